@@ -64,6 +64,7 @@
 // todo need this for lwip FreeRTOS sys_arch to compile
 #define configENABLE_BACKWARD_COMPATIBILITY     1
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   2  // slot 1: I2CBus transfer completion
 
 /* System */
 #define configSTACK_DEPTH_TYPE                  uint32_t
@@ -102,13 +103,22 @@
 #define configMAX_API_CALL_INTERRUPT_PRIORITY   [dependent on processor and application]
 */
 
-// #if FREE_RTOS_KERNEL_SMP // set by the RP2040 SMP port of FreeRTOS
-// /* SMP port only */
-// #define configNUMBER_OF_CORES                   2
-// #define configTICK_CORE                         0
-// #define configRUN_MULTIPLE_PRIORITIES           1
-// #define configUSE_CORE_AFFINITY                 1
-// #endif
+/* SMP: both RP2040 cores run tasks (cmake -DTRACKING_TRILHA_SMP=ON). Tasks
+are pinned with PinTaskToCore() from core_affinity.h: bus I/O and display on
+core 0, signal processing on core 1. */
+#ifndef TRACKING_TRILHA_SMP
+#define TRACKING_TRILHA_SMP                     0
+#endif
+
+#if TRACKING_TRILHA_SMP
+#define configNUMBER_OF_CORES                   2
+#define configTICK_CORE                         0
+#define configRUN_MULTIPLE_PRIORITIES           1
+#define configUSE_CORE_AFFINITY                 1
+#define configUSE_PASSIVE_IDLE_HOOK             0
+#else
+#define configNUMBER_OF_CORES                   1
+#endif
 
 /* RP2040 specific */
 #define configSUPPORT_PICO_SYNC_INTEROP         1
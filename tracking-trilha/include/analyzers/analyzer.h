@@ -1,6 +1,8 @@
 #pragma once
 #include "sensor.h"
 
+#define ANALYZER_DEFAULT_EWMA_ALPHA 0.1f  // used when the config leaves ewmaAlpha at 0
+
 typedef enum {
   HEALTH_STATUS_CRITICAL_LOW,
   HEALTH_STATUS_LOW,
@@ -10,17 +12,64 @@ typedef enum {
 } healthStatus_t;
 
 typedef struct {
-  float thresholds[HEALTH_STATUS_CRITICAL_HIGH + 1];
+  float thresholds[HEALTH_STATUS_CRITICAL_HIGH + 1];  // ascending lower bound of each status; below thresholds[0] is not classified
   sensor_t sensorType;
   sample_t sampleType;
+  float hysteresis;       // a sample must cross a threshold by this much to change status
+  uint16_t dwellSamples;  // consecutive samples a new status must hold before it is reported
+  float ewmaAlpha;        // weight of a new sample in the EWMA
 } analyzerConfig_t;
 
+// Statistics of every sample analyzed since construction or Reset()
+typedef struct {
+  float min;
+  float max;
+  float mean;
+  float ewma;
+  float last;
+  uint32_t count;
+} analyzerStats_t;
+
+// Everything Analyze() carries from one snapshot to the next
+typedef struct {
+  healthStatus_t status;     // reported status
+  healthStatus_t candidate;  // status waiting for its dwell time
+  uint32_t candidateSamples;
+  analyzerStats_t stats;
+} analyzerState_t;
+
+/**
+ * Streaming threshold analyzer.
+ *
+ * Analyze() only sees the samples that arrived since the previous snapshot and
+ * keeps its status and statistics between calls, so its cost is O(new samples).
+ * The status of a sample is the number of thresholds above the lowest one it
+ * reaches, found with four comparisons and no early exit. Samples below the
+ * lowest threshold only feed the statistics. A change of status needs the sample to clear the
+ * threshold by the hysteresis and then to stay there for dwellSamples samples, so
+ * values sitting on a threshold do not flicker.
+ *
+ * Analyze() works on a copy of the state and Commit() keeps it. A snapshot the
+ * producer overwrote while it was analyzed is never committed, so torn samples
+ * cannot move the status or the statistics.
+ */
 class Analyzer {
   public:
     Analyzer(analyzerConfig_t config);
     inline sensor_t GetSensorType() { return config.sensorType; }
     inline sample_t GetSampleType() { return config.sampleType; }
-    healthStatus_t Analyze(Data_t* data);
+    healthStatus_t Analyze(Data_t* data);  // status the snapshot leads to, not kept until Commit()
+    inline void Commit() { state = pending; }
+    void Reset();
+
+    inline healthStatus_t GetStatus() const { return state.status; }
+    inline const analyzerStats_t& GetStats() const { return state.stats; }
   private:
     analyzerConfig_t config;
-};
\ No newline at end of file
+
+    analyzerState_t state;    // committed
+    analyzerState_t pending;  // result of the last Analyze()
+
+    healthStatus_t Classify(float value) const;
+    void Accumulate(float value);
+};
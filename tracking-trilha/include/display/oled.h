@@ -1,14 +1,65 @@
 #pragma once
 
 #include "display_oled.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include <atomic>
 
+// FreeRTOS task configuration: the display task flushes the front framebuffer on i2c1,
+// below every sensor, state and bus task so a slow display never holds up data collection
+#define OLED_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define OLED_TASK_STACK_SIZE 512
+#define OLED_FRAME_PERIOD_MS 100  // at most 10 flushes per second; frames presented in between are merged
+
+/**
+ * 128x64 OLED with two framebuffers.
+ *
+ * The drawing calls compose into the back buffer and Render() presents it: the
+ * columns that changed are copied to the front buffer, which is the only one the
+ * display task sends. Once StartTask() ran, Render() never waits for the bus. If
+ * the task is flushing, the frame is dropped and its changes go out with the next
+ * Render(). A frame presented while an earlier one still waits for its flush slot
+ * replaces it and also counts as dropped. Without the task, Render() flushes inline.
+ *
+ * Drawing and Render() must come from one task.
+ */
 class Oled {
 public:
     Oled();
+    ~Oled();
     void Clear();
     void DrawPixel(int x, int y, bool is_white);
     void DrawLine(int x0, int y0, int x1, int y1, bool is_white);
     void DrawRect(int x0, int y0, int x1, int y1, bool is_white);
     void PrintText(int line_index, const char* text);
     void Render();
+
+    // Task management methods
+    void StartTask();
+    void StopTask();
+
+    // Frame statistics, readable from any task
+    inline uint32_t FrameTimeUs() const { return frameTimeUs.load(std::memory_order_relaxed); }  // last flush
+    inline uint32_t MaxFrameTimeUs() const { return maxFrameTimeUs.load(std::memory_order_relaxed); }
+    inline uint32_t FlushedFrames() const { return flushedFrames.load(std::memory_order_relaxed); }
+    inline uint32_t DroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+
+private:
+    static void DisplayTask(void* pvParameters);
+    void Flush();  // display task, or Render() itself before StartTask()
+    void CountDropped();
+
+    SemaphoreHandle_t frontLock;  // held by Render() while presenting and by the task while flushing
+    bool framePending;            // presented and not flushed yet, under frontLock
+
+    // Single-writer counters, updated with load + store
+    std::atomic<uint32_t> frameTimeUs;
+    std::atomic<uint32_t> maxFrameTimeUs;
+    std::atomic<uint32_t> flushedFrames;
+    std::atomic<uint32_t> droppedFrames;
+
+    // FreeRTOS task management
+    TaskHandle_t taskHandle;
+    bool taskRunning;
 };
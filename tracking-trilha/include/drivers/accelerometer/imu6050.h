@@ -2,6 +2,7 @@
 
 #include <pico/stdlib.h>
 #include <hardware/i2c.h>
+#include "i2c_bus.h"
 
 
 #define MPU_ADDR 0x68
@@ -23,6 +24,26 @@
 #define MPU_GYRO_ZOUT_H 0x47
 #define MPU_GYRO_ZOUT_L 0x48
 
+// Registradores da FIFO
+#define MPU_SMPLRT_DIV 0x19
+#define MPU_CONFIG 0x1A
+#define MPU_FIFO_EN 0x23
+#define MPU_USER_CTRL 0x6A
+#define MPU_FIFO_COUNTH 0x72
+#define MPU_FIFO_R_W 0x74
+
+#define MPU_FIFO_EN_ALL 0xF8  // TEMP, XG, YG, ZG e ACCEL na FIFO, gravados na ordem dos registros 0x3B..0x48
+#define MPU_USER_CTRL_FIFO_EN 0x40
+#define MPU_USER_CTRL_FIFO_RESET 0x04
+
+#define IMU6050_FIFO_SIZE 1024
+#define IMU6050_FRAME_BYTES 14  // registros 0x3B..0x48: accel X/Y/Z, temperatura, gyro X/Y/Z, big endian
+#define IMU6050_FIFO_MAX_FRAMES (IMU6050_FIFO_SIZE / IMU6050_FRAME_BYTES)
+#define IMU6050_FIFO_BURST_FRAMES 20  // quadros por leitura, 280 bytes cabem num DMA do barramento
+#define IMU6050_GYRO_RATE_HZ 1000  // taxa interna com o DLPF ligado, dividida por SMPLRT_DIV + 1
+#define IMU6050_ODR_MIN_HZ 4
+#define IMU6050_ODR_MAX_HZ 1000
+
 // Definições para conversão de unidades
 #define ACCEL_RANGE_2G (0x8000 / 2.0f)  // ±2g
 #define ACCEL_RANGE_4G (0x8000 / 4.0f)   // ±4g
@@ -46,6 +67,12 @@ typedef struct {
   float z;
 } imu6050_calibrated_t;
 
+typedef struct {
+  imu6050_data_t accel;
+  int16_t temperature;
+  imu6050_data_t gyro;
+} imu6050_frame_t;
+
 class IMU6050 {
 public:
     IMU6050(i2c_inst_t* i2c_type, uint8_t sdata , uint8_t sclk , uint32_t i2cSpeed = 400000, uint8_t i2cAddr = MPU_ADDR);
@@ -59,15 +86,28 @@ public:
     void read_accelerometer(imu6050_data_t *accel_data);
     void read_gyroscope(imu6050_data_t *gyro_data);
     float read_temperature();
+    bool read_frame(imu6050_frame_t *frame);  // accel, temperatura e gyro numa só leitura de 14 bytes
+
+    // Modo FIFO: o sensor amostra sozinho a odr_hz e os quadros são lidos em rajadas
+    bool enable_fifo(uint16_t odr_hz);
+    int read_frames(imu6050_frame_t *frames, size_t max_frames);  // -1 se a FIFO transbordou ou o barramento falhou
+    inline uint16_t fifo_odr() const { return _odr; }
+    inline uint32_t fifo_overflows() const { return _fifo_overflows; }
 
     // Funções para converter dados brutos em unidades físicas
     void convert_accelerometer_data(imu6050_data_t *raw_data, imu6050_calibrated_t *calibrated_data);
     void convert_gyroscope_data(imu6050_data_t *raw_data, imu6050_calibrated_t *calibrated_data);   
+    float convert_temperature(int16_t raw_temp);
 private:
-    i2c_inst_t *_i2c;
+    I2CBus *bus;
     uint8_t  _i2caddr;
     uint8_t _SDataPin;
     uint8_t _SClkPin;
     uint32_t _CLKSpeed;
+    uint16_t _odr;  // 0 enquanto a FIFO está desligada
+    uint32_t _fifo_overflows;
+
+    bool reset_fifo();
+    static void unpack_frame(const uint8_t *bytes, imu6050_frame_t *frame);
 
 };
\ No newline at end of file
@@ -19,7 +19,13 @@
 // ssd1306_width pixels por ssd1306_n_pages páginas
 extern struct render_area frame_area;
 
-extern uint8_t ssd[ssd1306_buffer_length];
+// Quadro de ssd_frame, logo após o byte de controle 0x40
+extern uint8_t ssd_frame[ssd1306_frame_length];
+extern uint8_t *const ssd;
+
+// Quadro da frente, o que vai para o display; só muda em present_OLed
+extern uint8_t ssd_front_frame[ssd1306_frame_length];
+extern uint8_t *const ssd_front;
 
 void init_OLed();
 
@@ -32,5 +38,7 @@ void draw_point_OLed(int x, int y, bool is_white);
 void draw_line_OLed(int x0, int y0, int x1, int y1, bool is_white);
 
 void render_OLed();
+bool present_OLed();
+void flush_OLed();
 
 void draw_rect_OLed(int x0, int y0, int x1, int y1, bool is_white);
@@ -7,6 +7,15 @@ extern void ssd1306_send_buffer(uint8_t ssd[], int buffer_length);
 extern void ssd1306_init();
 extern void ssd1306_scroll(bool set);
 extern void render_on_display(uint8_t *ssd, struct render_area *area);
+extern void ssd1306_track_dirty(uint8_t *ssd);
+extern void ssd1306_mark_dirty(uint8_t *ssd, int start_page, int end_page, int start_column, int end_column);
+extern void ssd1306_clear_dirty(struct dirty_area *dirty);
+extern bool ssd1306_take_dirty(uint8_t *ssd, struct dirty_area *dirty);
+extern void ssd1306_copy_dirty(uint8_t *dst, const uint8_t *src, const struct dirty_area *dirty);
+// Estes dois enviam o quadro sem cópia: ssd precisa ter um byte reservado antes do primeiro
+// pixel, como ssd_frame (ver ssd1306_frame_length). Os demais envios aceitam qualquer buffer
+extern void render_dirty_on_display(uint8_t *ssd);
+extern void render_dirty_area(uint8_t *ssd, struct dirty_area *dirty);
 extern void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set);
 extern void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool set);
 extern void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character);
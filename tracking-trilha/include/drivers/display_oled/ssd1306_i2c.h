@@ -45,6 +45,9 @@
 #define ssd1306_page_height _u(8)
 #define ssd1306_n_pages (ssd1306_height / ssd1306_page_height)
 #define ssd1306_buffer_length (ssd1306_n_pages * ssd1306_width)
+#define ssd1306_frame_length (ssd1306_buffer_length + 1) // byte de controle 0x40 + quadro, enviado sem cópia
+
+#define ssd1306_command_list_max 32 // comandos por transação (Co = 0)
 
 #define ssd1306_write_mode _u(0xFE)
 #define ssd1306_read_mode _u(0xFF)
@@ -58,6 +61,12 @@ struct render_area {
     int buffer_length;
 };
 
+// Faixa de colunas alterada em cada página; start_column > end_column quando a página está limpa
+struct dirty_area {
+    uint8_t start_column[ssd1306_n_pages];
+    uint8_t end_column[ssd1306_n_pages];
+};
+
 typedef struct {
   uint8_t width, height, pages, address;
   i2c_inst_t * i2c_port;
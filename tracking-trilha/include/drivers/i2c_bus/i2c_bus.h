@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#define I2C_BUS_QUEUE_LENGTH        8     // pending transfers per priority
+#define I2C_BUS_TASK_PRIORITY       (tskIDLE_PRIORITY + 5)  // above every driver task it serves
+#define I2C_BUS_TASK_STACK_SIZE     512
+#define I2C_BUS_NOTIFY_INDEX        1     // task notification slot callers wait on, 0 stays free for drivers
+#define I2C_BUS_TIMEOUT_US          2000  // per transfer, plus I2C_BUS_TIMEOUT_US_PER_BYTE
+#define I2C_BUS_TIMEOUT_US_PER_BYTE 100
+#define I2C_BUS_DMA_MIN_BYTES       16    // shorter reads are cheaper through the FIFO
+#define I2C_BUS_DMA_MAX_BYTES       288   // one MAX3010X FIFO: 32 samples x 3 LEDs x 3 bytes
+
+// Queue served first. Within one priority transfers run in submission order.
+typedef enum i2c_priority_t {
+    I2C_PRIORITY_HIGH,    // FIFO drains, data is lost if they wait
+    I2C_PRIORITY_NORMAL,  // periodic sensor reads
+    I2C_PRIORITY_LOW,     // configuration, die temperature
+    I2C_PRIORITY_QTT
+} i2c_priority_t;
+
+// One write-then-read transfer: tx goes out first (typically the register
+// address), then rxLength bytes are read after a repeated start. Either part
+// may be empty.
+typedef struct {
+    uint8_t address;
+    const uint8_t *tx;
+    size_t txLength;
+    uint8_t *rx;
+    size_t rxLength;
+    bool ok;
+    TaskHandle_t caller;
+} i2c_transfer_t;
+
+/**
+ * Owner of one I2C controller, shared by every driver on that bus.
+ *
+ * Once the scheduler runs, transfers from all tasks are queued by priority and
+ * executed by a single bus task, so drivers never take a lock of their own and
+ * a FIFO drain never waits behind a configuration write. When the next queued
+ * transfer targets the same device, the bus keeps it (repeated start instead
+ * of STOP + START) and both go out as one bus transaction. Before the
+ * scheduler starts, transfers run inline on the caller.
+ */
+class I2CBus {
+  public:
+    static I2CBus* Get(i2c_inst_t* i2c);
+
+    // Initializes the controller on first use; later calls must use the same pins
+    bool begin(uint8_t sdaPin, uint8_t sclPin, uint32_t speed);
+    bool EnableDMA();  // long reads go through two DMA channels instead of the CPU
+
+    bool Transfer(uint8_t address, const uint8_t* tx, size_t txLength, uint8_t* rx, size_t rxLength, i2c_priority_t priority = I2C_PRIORITY_NORMAL);
+    bool ReadRegisters(uint8_t address, uint8_t reg, uint8_t* dst, size_t length, i2c_priority_t priority = I2C_PRIORITY_NORMAL);
+    bool WriteRegister(uint8_t address, uint8_t reg, uint8_t value, i2c_priority_t priority = I2C_PRIORITY_LOW);
+
+    inline uint32_t Transactions() const { return transactions; }
+    inline uint32_t Coalesced() const { return coalesced; }  // transfers that rode on the previous one's transaction
+
+  private:
+    I2CBus();
+
+    bool Execute(i2c_transfer_t* transfer, bool holdBus);
+    bool ReadDMA(uint8_t* dst, size_t length, bool holdBus);
+    bool Dequeue(i2c_transfer_t** transfer);
+    bool Peek(i2c_transfer_t** transfer, size_t* queue);
+    static void BusTask(void* pvParameters);
+    static void DmaIrqHandler(void);
+
+    static I2CBus buses[NUM_I2CS];
+
+    i2c_inst_t* _i2c;
+    uint8_t _sdaPin;
+    uint8_t _sclPin;
+    bool initialized;
+
+    QueueHandle_t queues[I2C_PRIORITY_QTT];
+    TaskHandle_t taskHandle;
+
+    int dmaTxChannel;
+    int dmaRxChannel;
+    SemaphoreHandle_t dmaDone;
+    uint16_t dmaCommands[I2C_BUS_DMA_MAX_BYTES];
+
+    uint32_t transactions;
+    uint32_t coalesced;
+};
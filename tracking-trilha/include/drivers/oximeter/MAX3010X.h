@@ -3,24 +3,23 @@
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "FreeRTOS.h"
-#include "semphr.h"
+#include "i2c_bus.h"
 
 #define MAX3010X_ADDRESS	0x57
 
-#define I2C_BUFFER_LENGTH	32
-
 #define I2C_DELAY        	50000
 
-class MAX3010X {
+#define MAX3010X_FIFO_DEPTH	32
+#define MAX3010X_FIFO_BYTES	(MAX3010X_FIFO_DEPTH * 3 * 3) // 32 samples x 3 LEDs x 3 bytes
+
+#define MAX3010X_STORAGE_SIZE	32 // default sample storage depth per LED
+
+// Register access, configuration and raw FIFO transfers. Sample storage lives in MAX3010X<> below.
+class MAX3010XBase {
 	public:
-		MAX3010X(i2c_inst_t* i2c_type, uint8_t sdata , uint8_t sclk , uint32_t i2cSpeed, uint8_t i2cAddr = MAX3010X_ADDRESS);
+		MAX3010XBase(i2c_inst_t* i2c_type, uint8_t sdata , uint8_t sclk , uint32_t i2cSpeed, uint8_t i2cAddr = MAX3010X_ADDRESS);
 		bool begin();
 
-		uint32_t getRed(void); // Returns immediate red value
-		uint32_t getIR(void); // Returns immediate IR value
-		uint32_t getGreen(void); 
-		bool safeCheck(uint8_t maxTimeToCheck); // Given a max amount of time, checks for new data.
-		
 		// Configuration
 		void softReset();
 		void shutDown();
@@ -67,12 +66,9 @@ class MAX3010X {
 		void setFIFOAlmostFull(uint8_t samples);
 
 		// FIFO Reading
-		uint16_t check(void);
-		uint8_t available(void);
-		void nextSample(void);
-		uint32_t getFIFORed(void);
-		uint32_t getFIFOIR(void);
-		uint32_t getFIFOGreen(void);
+		bool enableBurstDMA(void); // optional: the bus drains the FIFO with one DMA-fed I2C transfer
+		uint16_t readFIFOBurst(uint8_t *dst, size_t capacity); // raw FIFO bytes, returns samples read
+		static void unpackFIFO(const uint8_t *src, uint16_t samples, uint8_t activeLEDs, uint32_t *red, uint32_t *ir, uint32_t *green);
 
 		uint8_t getWritePointer(void);
 		uint8_t getReadPointer(void);
@@ -91,40 +87,232 @@ class MAX3010X {
 
 		// Setup the sensor with user selectable settings
 		void setup(uint8_t powerLevel = 0x1F, uint8_t sampleAverage = 4, uint8_t ledMode = 3, int sampleRate = 400, int pulseWidth = 411, int adcRange = 4096);
+		// Change averaging, ADC rate and LED amplitude while running, without the reset of setup()
+		void setAcquisition(uint8_t powerLevel, uint8_t sampleAverage, int sampleRate);
 
-		// I2C Communication
-		uint8_t readRegister(uint8_t address, uint8_t reg);
-		void writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+		// I2C Communication, through the shared bus of the controller
+		uint8_t readRegister(uint8_t address, uint8_t reg, i2c_priority_t priority = I2C_PRIORITY_LOW);
+		void writeRegister(uint8_t address, uint8_t reg, uint8_t value, i2c_priority_t priority = I2C_PRIORITY_LOW);
 		
+	protected:
+		static void pollDelayMs(uint32_t ms);
+
+		uint8_t activeLEDs;
+		uint8_t burstBuffer[MAX3010X_FIFO_BYTES];
+
 	private:
-		i2c_inst_t *_i2c;
+		I2CBus *bus;
 		uint8_t  _i2caddr;
 		uint8_t _SDataPin;
 		uint8_t _SClkPin;
 		uint32_t _CLKSpeed;
 
-		uint8_t activeLEDs;
-
 		uint8_t revisionID;
 
 		void readRevisionID();
 
 		void bitMask(uint8_t reg, uint8_t mask, uint8_t thing);
+};
+
+/**
+ * MAX3010X driver with STORAGE_SIZE samples of storage per LED.
+ * The storage must hold at least a whole hardware FIFO so a burst read
+ * never overwrites samples that have not been consumed yet.
+ */
+template <uint16_t STORAGE_SIZE = MAX3010X_STORAGE_SIZE>
+class MAX3010X : public MAX3010XBase {
+	static_assert(STORAGE_SIZE >= MAX3010X_FIFO_DEPTH, "MAX3010X storage must hold a whole hardware FIFO");
+	static_assert((STORAGE_SIZE & (STORAGE_SIZE - 1)) == 0, "MAX3010X storage size must be a power of two");
+
+	public:
+		using MAX3010XBase::MAX3010XBase;
+
+		uint32_t getRed(void); // Returns immediate red value
+		uint32_t getIR(void); // Returns immediate IR value
+		uint32_t getGreen(void); 
+		bool safeCheck(uint8_t maxTimeToCheck); // Given a max amount of time, checks for new data.
+
+		// FIFO Reading
+		uint16_t check(void);
+		uint16_t available(void);
+		void nextSample(void);
+		uint32_t getFIFORed(void);
+		uint32_t getFIFOIR(void);
+		uint32_t getFIFOGreen(void);
+		// Copy up to max of the oldest samples out in one call; nullptr skips a channel
+		uint16_t readSamples(uint32_t *red, uint32_t *ir, uint32_t *green, uint16_t max);
+
+	private:
+		static constexpr uint32_t MASK = STORAGE_SIZE - 1;
 
-		uint8_t readMany[16];
+		void storeSamples(const uint8_t *raw, uint16_t samples);
+		static void copyOut(uint32_t *dst, const uint32_t *src, uint32_t start, uint16_t count);
 
-		#define STORAGE_SIZE 4
-		typedef struct Record 
-		{
+		// head counts samples stored and tail samples consumed; both run freely
+		struct {
 			uint32_t red[STORAGE_SIZE];
 			uint32_t IR[STORAGE_SIZE];
-    		uint32_t green[STORAGE_SIZE];
-			uint8_t head;
-			uint8_t tail;
-		} sense_struct;
+			uint32_t green[STORAGE_SIZE];
+			uint32_t head;
+			uint32_t tail;
+		} sense = {};
+};
 
-		sense_struct sense;
-		
-		// Thread safety
-		SemaphoreHandle_t i2cMutex;
-};
\ No newline at end of file
+/**
+ * Returns the number of samples available.
+ */
+template <uint16_t STORAGE_SIZE>
+uint16_t MAX3010X<STORAGE_SIZE>::available(void) {
+	return (uint16_t)(sense.head - sense.tail);
+}
+
+/**
+ * Report the most recent Red value.
+ */
+template <uint16_t STORAGE_SIZE>
+uint32_t MAX3010X<STORAGE_SIZE>::getRed(void) {
+	if(safeCheck(250))
+		return (sense.red[(sense.head - 1) & MASK]);
+	else
+		return(0);
+}
+
+/**
+ * Report the most recent IR value.
+ */
+template <uint16_t STORAGE_SIZE>
+uint32_t MAX3010X<STORAGE_SIZE>::getIR(void) {
+	if(safeCheck(250))
+		return (sense.IR[(sense.head - 1) & MASK]);
+	else
+		return(0);
+}
+
+/**
+ * Report the most recent Green value.
+ */
+template <uint16_t STORAGE_SIZE>
+uint32_t MAX3010X<STORAGE_SIZE>::getGreen(void) {
+	if(safeCheck(250))
+		return (sense.green[(sense.head - 1) & MASK]);
+	else
+		return(0);
+}
+
+/**
+ * Report the next Red value in FIFO.
+ */
+template <uint16_t STORAGE_SIZE>
+uint32_t MAX3010X<STORAGE_SIZE>::getFIFORed(void) {
+	return (sense.red[sense.tail & MASK]);
+}
+
+/**
+ * Report the next IR value in FIFO.
+ */
+template <uint16_t STORAGE_SIZE>
+uint32_t MAX3010X<STORAGE_SIZE>::getFIFOIR(void) {
+	return (sense.IR[sense.tail & MASK]);
+}
+
+/**
+ * Report the next Green value in FIFO.
+ */
+template <uint16_t STORAGE_SIZE>
+uint32_t MAX3010X<STORAGE_SIZE>::getFIFOGreen(void) {
+	return (sense.green[sense.tail & MASK]);
+}
+
+/**
+ * Advance the tail.
+ */
+template <uint16_t STORAGE_SIZE>
+void MAX3010X<STORAGE_SIZE>::nextSample(void) {
+	if(available()) {
+		sense.tail++;
+	}
+}
+
+template <uint16_t STORAGE_SIZE>
+void MAX3010X<STORAGE_SIZE>::copyOut(uint32_t *dst, const uint32_t *src, uint32_t start, uint16_t count) {
+	if (dst == nullptr) return;
+	uint32_t index = start & MASK;
+	uint16_t first = STORAGE_SIZE - index;
+	if (first > count) first = count;
+	memcpy(dst, &src[index], first * sizeof(uint32_t));
+	memcpy(dst + first, &src[0], (count - first) * sizeof(uint32_t));
+}
+
+/**
+ * Bulk version of getFIFORed()/getFIFOIR()/getFIFOGreen() + nextSample().
+ * Returns the number of samples copied.
+ */
+template <uint16_t STORAGE_SIZE>
+uint16_t MAX3010X<STORAGE_SIZE>::readSamples(uint32_t *red, uint32_t *ir, uint32_t *green, uint16_t max) {
+	uint16_t count = available();
+	if (count > max) count = max;
+
+	copyOut(red, sense.red, sense.tail, count);
+	copyOut(ir, sense.IR, sense.tail, count);
+	copyOut(green, sense.green, sense.tail, count);
+
+	sense.tail += count;
+	return count;
+}
+
+/**
+ * Poll the sensor for new data and store it.
+ * Returns the number of new samples.
+ */
+template <uint16_t STORAGE_SIZE>
+uint16_t MAX3010X<STORAGE_SIZE>::check(void) {
+	uint16_t numberOfSamples = readFIFOBurst(burstBuffer, sizeof(burstBuffer));
+	storeSamples(burstBuffer, numberOfSamples);
+	return numberOfSamples;
+}
+
+// Append raw FIFO words to the storage, one contiguous run per wrap
+template <uint16_t STORAGE_SIZE>
+void MAX3010X<STORAGE_SIZE>::storeSamples(const uint8_t *raw, uint16_t samples) {
+	size_t sampleBytes = activeLEDs * 3;
+	while (samples > 0) {
+		uint32_t start = sense.head & MASK;
+		uint16_t run = STORAGE_SIZE - start;
+		if (run > samples) run = samples;
+
+		unpackFIFO(raw, run, activeLEDs, &sense.red[start], &sense.IR[start], &sense.green[start]);
+
+		sense.head += run;
+		raw += run * sampleBytes;
+		samples -= run;
+	}
+
+	// Oldest unread samples were overwritten
+	if (sense.head - sense.tail > STORAGE_SIZE) {
+		sense.tail = sense.head - STORAGE_SIZE;
+	}
+}
+
+/**
+ * Check for new data but give up after a certain amount of time.
+ * Returns true if new data was found.
+ * Returns false if new data was not found.
+ */
+template <uint16_t STORAGE_SIZE>
+bool MAX3010X<STORAGE_SIZE>::safeCheck(uint8_t maxTimeToCheck) {
+	uint32_t markTime = to_ms_since_boot(get_absolute_time());
+
+	while(1) {
+		uint32_t endTime = to_ms_since_boot(get_absolute_time());
+		if (endTime - markTime > maxTimeToCheck) {
+			return false;
+		}
+
+		if (check() > 0) {
+			// We found new data!
+			return true;
+		}
+
+		pollDelayMs(1);
+	}
+}
\ No newline at end of file
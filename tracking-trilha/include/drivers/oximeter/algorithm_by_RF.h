@@ -41,14 +41,10 @@
  * Leave these alone if your circuit and hardware setup match the defaults 
  * described in this code's Instructable. Typically, different sampling rate
  * and/or sample length would require these paramteres to be adjusted.
+ * Everything that depends on them is derived at compile time by RFConfig below.
  */
-#define ST 1      // Sampling time in s. WARNING: if you change ST, then you MUST recalcuate the sum_X2 parameter below!
-#define FS 25     // Sampling frequency in Hz. WARNING: if you change FS, then you MUST recalcuate the sum_X2 parameter below!
-// Sum of squares of ST*FS numbers from -mean_X (see below) to +mean_X incremented be one. For example, given ST=4 and FS=25,
-// the sum consists of 100 terms: (-49.5)^2 + (-48.5)^2 + (-47.5)^2 + ... + (47.5)^2 + (48.5)^2 + (49.5)^2
-// The sum is symmetrc, so you can evaluate it by multiplying its positive half by 2. It is precalcuated here for enhanced 
-// performance.
-const float sum_X2 = 5200; // WARNING: you MUST recalculate this sum if you changed either ST or FS above!
+const int32_t ST = 1;   // Sampling time in s of the default configuration
+const int32_t FS = 25;  // Sampling frequency in Hz of the default configuration
 // WARNING: The two parameters below are CRUCIAL! Proper HR evaluation depends on these.
 #define MAX_HR 180  // Maximal heart rate. To eliminate erroneous signals, calculated HR should never be greater than this number.
 #define MIN_HR 40   // Minimal heart rate. To eliminate erroneous signals, calculated HR should never be lower than this number.
@@ -58,17 +54,67 @@ const float min_autocorrelation_ratio = 0.5;
 // Pearson correlation between red and IR signals.
 // Good quality signals must have their correlation coefficient greater than this minimum.
 const float min_pearson_correlation = 0.8;
+// Set to 1 to run HR/SpO2 on integer-only arithmetic (no soft float on cores without an FPU).
+// RFStream::Compute() then hands its window to rf_heart_rate_and_oxygen_saturation_fixed().
+#ifndef RF_FIXED_POINT
+#define RF_FIXED_POINT 0
+#endif
+
+// Runtime copy of an RFConfig for the non-template parts of the algorithm
+typedef struct {
+  int32_t n_buffer_size;    // samples per window
+  int32_t n_fs60;           // heart rate in bpm = n_fs60/period
+  int32_t n_lowest_period;  // minimal distance between peaks
+  int32_t n_highest_period; // maximal distance between peaks
+  int32_t n_aut_first_lag;  // lowest lag other than 0 the periodicity searches read
+  int32_t n_aut_table_size; // lags 0 .. n_aut_table_size-1 cover everything the searches read
+  int32_t n_twice_sum_x2;   // 2*sum_X2 = (N^3-N)/6, always integral
+  float f_mean_x;
+  float f_sum_x2;
+} rf_params_t;
+
+/*
+ * Derived parameters for a sampling rate and window duration.
+ * Configurations are independent types, so e.g. a fast 1 s window and an accurate
+ * 4 s window can run side by side.
+ */
+template <int32_t SAMPLE_RATE, int32_t SECONDS>
+struct RFConfig {
+  static constexpr int32_t FS = SAMPLE_RATE;
+  static constexpr int32_t ST = SECONDS;
+  static constexpr int32_t BUFFER_SIZE = FS*ST; // Number of samples in a single batch
+  static constexpr int32_t FS60 = FS*60;  // Conversion factor for heart rate from bps to bpm
+  static constexpr int32_t LOWEST_PERIOD = FS60/MAX_HR; // Minimal distance between peaks
+  static constexpr int32_t HIGHEST_PERIOD = FS60/MIN_HR; // Maximal distance between peaks
+  static constexpr int32_t AUT_TABLE_SIZE = HIGHEST_PERIOD+3; // the searches may step up to two lags past HIGHEST_PERIOD
+  static constexpr int32_t AUT_FIRST_LAG = LOWEST_PERIOD-1;   // ... and one lag below LOWEST_PERIOD
+  // Mean value of the set of integers from 0 to BUFFER_SIZE-1. For ST=4 and FS=25 it's equal to 49.5.
+  static constexpr float mean_X = (float)(BUFFER_SIZE-1)/2.0f;
+  // Sum of squares of the BUFFER_SIZE numbers from -mean_X to +mean_X incremented by one, (N^3-N)/12.
+  // For ST=4 and FS=25: (-49.5)^2 + (-48.5)^2 + ... + (48.5)^2 + (49.5)^2 = 83325.
+  static constexpr float sum_X2 = (float)((int64_t)BUFFER_SIZE*BUFFER_SIZE*BUFFER_SIZE - BUFFER_SIZE)/12.0f;
+
+  static constexpr int32_t TWICE_SUM_X2 = (int32_t)(((int64_t)BUFFER_SIZE*BUFFER_SIZE*BUFFER_SIZE - BUFFER_SIZE)/6);
+
+  static constexpr rf_params_t PARAMS = {BUFFER_SIZE, FS60, LOWEST_PERIOD, HIGHEST_PERIOD, AUT_FIRST_LAG, AUT_TABLE_SIZE, TWICE_SUM_X2, mean_X, sum_X2};
+
+  static_assert(BUFFER_SIZE >= 2, "RF window needs at least two samples");
+  static_assert(LOWEST_PERIOD >= 2, "RF sampling rate too low to resolve MAX_HR");
+};
 
 /*
- * Derived parameters 
+ * Default configuration, used by the batch functions below.
  * Do not touch these! 
- * 
  */
-const int32_t BUFFER_SIZE = FS*ST; // Number of smaples in a single batch
-const int32_t FS60 = FS*60;  // Conversion factor for heart rate from bps to bpm
-const int32_t LOWEST_PERIOD = FS60/MAX_HR; // Minimal distance between peaks
-const int32_t HIGHEST_PERIOD = FS60/MIN_HR; // Maximal distance between peaks
-const float mean_X = (float)(BUFFER_SIZE-1)/2.0; // Mean value of the set of integers from 0 to BUFFER_SIZE-1. For ST=4 and FS=25 it's equal to 49.5.
+typedef RFConfig<FS, ST> RFDefaultConfig;
+const int32_t BUFFER_SIZE = RFDefaultConfig::BUFFER_SIZE;
+const int32_t FS60 = RFDefaultConfig::FS60;
+const int32_t LOWEST_PERIOD = RFDefaultConfig::LOWEST_PERIOD;
+const int32_t HIGHEST_PERIOD = RFDefaultConfig::HIGHEST_PERIOD;
+const float mean_X = RFDefaultConfig::mean_X;
+const float sum_X2 = RFDefaultConfig::sum_X2;
+const int32_t RF_AUT_TABLE_SIZE = RFDefaultConfig::AUT_TABLE_SIZE;
+const int32_t RF_AUT_FIRST_LAG = RFDefaultConfig::AUT_FIRST_LAG;
 
 void rf_heart_rate_and_oxygen_saturation(uint32_t *pun_ir_buffer, int32_t n_ir_buffer_length, uint32_t *pun_red_buffer, float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, 
                                         int8_t *pch_hr_valid, float *ratio, float *correl);
@@ -78,5 +124,21 @@ float rf_rms(float *pn_x, int32_t n_size, float *sumsq);
 float rf_Pcorrelation(float *pn_x, float *pn_y, int32_t n_size);
 void rf_initialize_periodicity_search(float *pn_x, int32_t n_size, int32_t *p_last_periodicity, int32_t n_max_distance, float min_aut_ratio, float aut_lag0);
 void rf_signal_periodicity(float *pn_x, int32_t n_size, int32_t *p_last_periodicity, int32_t n_min_distance, int32_t n_max_distance, float min_aut_ratio, float aut_lag0, float *ratio);
+// Same searches over a precomputed autocorrelation table (pn_aut[lag], lag 0 and n_aut_first_lag .. n_aut_table_size-1)
+void rf_initialize_periodicity_search_table(const float *pn_aut, int32_t *p_last_periodicity, int32_t n_max_distance, float min_aut_ratio, float aut_lag0);
+void rf_signal_periodicity_table(const float *pn_aut, int32_t *p_last_periodicity, int32_t n_min_distance, int32_t n_max_distance, float min_aut_ratio, float aut_lag0, float *ratio);
+// Periodicity search and SpO2 curve shared by the table-driven (streaming) pipelines
+void rf_finish_from_table(const rf_params_t *pp, const float *pn_aut, float f_ir_mean, float f_red_mean, float f_ir_sumsq, float f_red_sumsq,
+                          float f_correl, int32_t *pn_last_peak_interval, float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate,
+                          int8_t *pch_hr_valid, float *ratio);
+// Fixed-point build of rf_heart_rate_and_oxygen_saturation(): same decisions on integer arithmetic only, over
+// pp->n_buffer_size samples. pn_scratch holds RF_FIXED_SCRATCH(CFG) words. *pn_last_peak_interval carries
+// the periodicity between calls and must start at pp->n_lowest_period.
+#define RF_FIXED_SCRATCH(CFG) (2*(CFG::BUFFER_SIZE) + (CFG::AUT_TABLE_SIZE))
+void rf_heart_rate_and_oxygen_saturation_fixed(const rf_params_t *pp, const uint32_t *pun_ir_buffer, const uint32_t *pun_red_buffer, int32_t *pn_scratch,
+                                              int32_t *pn_last_peak_interval, float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate,
+                                              int8_t *pch_hr_valid, float *ratio, float *correl);
+// Blocked kernel of the fixed-point pipeline: pn_aut[lag] for lag = n_first_lag .. n_lags-1, four lags per pass
+void rf_fixed_autocorrelation_all(const int32_t *pn_x, int32_t n_size, int32_t n_first_lag, int32_t n_lags, int32_t *pn_aut);
 
 #endif /* ALGORITHM_BY_RF_H_ */
\ No newline at end of file
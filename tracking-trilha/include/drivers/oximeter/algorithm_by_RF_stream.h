@@ -0,0 +1,214 @@
+/*
+ * Sliding-window variant of rf_heart_rate_and_oxygen_saturation().
+ *
+ * Instead of recomputing mean, linear trend, RMS, Pearson correlation and the
+ * autocorrelation scan for every batch, the stream keeps exact integer running
+ * sums over the last CFG::BUFFER_SIZE samples and updates them in O(lags) per new
+ * sample. Compute() turns those sums into the same quantities the batch function
+ * derives from its detrended arrays, so results can be emitted at any hop instead
+ * of once per full batch.
+ *
+ * CFG is an RFConfig<SAMPLE_RATE, SECONDS>; every size is fixed at compile time,
+ * so streams of different configurations can be instantiated side by side.
+ */
+#ifndef ALGORITHM_BY_RF_STREAM_H_
+#define ALGORITHM_BY_RF_STREAM_H_
+
+#include <stdint.h>
+#include <math.h>
+#include "algorithm_by_RF.h"
+
+// Smallest power of two greater than n
+constexpr int32_t rf_stream_history(int32_t n) {
+  int32_t h = 1;
+  while (h <= n) h <<= 1;
+  return h;
+}
+
+#if !RF_FIXED_POINT
+// Detrended lag product of a window of n_size samples, see algorithm_by_RF_stream.cpp
+double rf_stream_detrended_lag(int32_t n_size, int64_t n_lag_sum, int64_t n_sum, int64_t n_ksum, int32_t n_lag,
+                               int64_t n_head_sum, int64_t n_head_ksum, int64_t n_tail_sum, int64_t n_tail_ksum, double beta);
+#endif
+
+template <class CFG>
+class RFStream {
+  // N^2 * sum(x_k*x_(k+lag)) with 18-bit samples has to stay within int64
+  static_assert(CFG::BUFFER_SIZE <= 256, "RFStream running sums overflow beyond 256 samples per window");
+
+  public:
+    static constexpr int32_t N = CFG::BUFFER_SIZE;
+    static constexpr int32_t HISTORY = rf_stream_history(N); // raw sample history, holds a window plus the incoming sample
+    // Lags with a non-empty autocorrelation sum; larger lags of the search table read as 0
+    static constexpr int32_t LAGS = N < CFG::AUT_TABLE_SIZE ? N : CFG::AUT_TABLE_SIZE;
+
+    RFStream() { Reset(); }
+
+    void Reset();
+    void Push(uint32_t un_ir, uint32_t un_red);
+    inline bool Ready() const { return n_size == N; }
+    void Compute(float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid, float *ratio, float *correl);
+
+  private:
+    static constexpr uint32_t MASK = HISTORY - 1;
+
+    uint32_t ir[HISTORY];
+    uint32_t red[HISTORY];
+    uint32_t n_head;               // history index of the next sample, free running
+    int32_t n_size;                // samples in the window, saturates at N
+
+    // Sums over the current window, k = 0 .. N-1 from oldest to newest
+    int64_t ir_sum, red_sum;       // sum x_k
+    int64_t ir_ksum, red_ksum;     // sum k*x_k
+    int64_t red_sumsq;             // sum red_k^2
+    int64_t cross;                 // sum ir_k*red_k
+    int64_t ir_lag[LAGS];          // sum ir_k*ir_(k+lag), lag 0 is the IR sum of squares
+
+    int32_t n_last_peak_interval;  // periodicity carried from one window to the next
+};
+
+/**
+* \brief        Reset the stream
+* \par          Details
+*               Drops all samples and the carried periodicity. Results are available again once
+*               N samples have been pushed.
+*/
+template <class CFG>
+void RFStream<CFG>::Reset()
+{
+  int32_t n_lag;
+  n_head = 0;
+  n_size = 0;
+  ir_sum = red_sum = 0;
+  ir_ksum = red_ksum = 0;
+  red_sumsq = 0;
+  cross = 0;
+  for (n_lag=0; n_lag<LAGS; ++n_lag) ir_lag[n_lag] = 0;
+  n_last_peak_interval = CFG::LOWEST_PERIOD;
+}
+
+/**
+* \brief        Append one sample
+* \par          Details
+*               Once the window is full the oldest sample leaves it and the remaining ones are
+*               renumbered one position down. O(LAGS) per call.
+*/
+template <class CFG>
+void RFStream<CFG>::Push(uint32_t un_ir, uint32_t un_red)
+{
+  int32_t n_lag, n_k;
+  int64_t x_ir = un_ir, x_red = un_red;
+  uint32_t n_in = n_head;
+
+  if (n_size == N) {
+    uint32_t n_out = n_in - N;
+    int64_t ir_out = ir[n_out & MASK];
+    int64_t red_out = red[n_out & MASK];
+    for (n_lag=0; n_lag<LAGS; ++n_lag)
+      ir_lag[n_lag] -= ir_out*ir[(n_out + n_lag) & MASK];
+    // sum k*x over the survivors, each one index lower
+    ir_ksum -= ir_sum - ir_out;
+    red_ksum -= red_sum - red_out;
+    ir_sum -= ir_out;
+    red_sum -= red_out;
+    red_sumsq -= red_out*red_out;
+    cross -= ir_out*red_out;
+    n_k = N-1;
+  } else {
+    n_k = n_size++;
+  }
+
+  ir[n_in & MASK] = un_ir;
+  red[n_in & MASK] = un_red;
+  n_head = n_in + 1;
+
+  ir_sum += x_ir;
+  red_sum += x_red;
+  ir_ksum += n_k*x_ir;
+  red_ksum += n_k*x_red;
+  red_sumsq += x_red*x_red;
+  cross += x_ir*x_red;
+  for (n_lag=0; n_lag<LAGS && n_lag<=n_k; ++n_lag)
+    ir_lag[n_lag] += x_ir*ir[(n_in - n_lag) & MASK];
+}
+
+/**
+* \brief        Heart rate and SpO2 of the current window
+* \par          Details
+*               Same decisions and outputs as rf_heart_rate_and_oxygen_saturation() on the last
+*               N pushed samples. The periodicity found is carried to the next call just like the
+*               batch function's static state. RF_FIXED_POINT selects the integer pipeline, which
+*               unrolls the window out of the history; otherwise everything comes from the running
+*               sums in O(LAGS).
+*/
+template <class CFG>
+void RFStream<CFG>::Compute(float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate, int8_t *pch_hr_valid, float *ratio, float *correl)
+{
+  uint32_t n_first = n_head - N;
+
+  if (!Ready()) {
+    *pn_heart_rate = -999;
+    *pch_hr_valid  = 0;
+    *pn_spo2 =  -999;
+    *pch_spo2_valid  = 0;
+    return;
+  }
+
+#if RF_FIXED_POINT
+  int32_t k;
+  uint32_t aun_ir[N], aun_red[N];
+  int32_t an_scratch[RF_FIXED_SCRATCH(CFG)];
+
+  for (k=0; k<N; ++k) {
+    aun_ir[k] = ir[(n_first + k) & MASK];
+    aun_red[k] = red[(n_first + k) & MASK];
+  }
+  rf_heart_rate_and_oxygen_saturation_fixed(&CFG::PARAMS, aun_ir, aun_red, an_scratch, &n_last_peak_interval,
+                                            pn_spo2, pch_spo2_valid, pn_heart_rate, pch_hr_valid, ratio, correl);
+#else
+  int32_t n_lag;
+  int64_t n_head_sum=0, n_head_ksum=0, n_tail_sum=0, n_tail_ksum=0;
+  float an_aut[CFG::AUT_TABLE_SIZE] = {0};
+  float f_ir_mean,f_red_mean,f_ir_sumsq,f_red_sumsq;
+  double beta_ir, beta_red, sum_xy;
+
+  f_ir_mean = (double)ir_sum/N;
+  f_red_mean = (double)red_sum/N;
+
+  // sum(d_k*x_k) = sum(k*x_k) - mean_X*sum(x_k), doubled to stay integral
+  beta_ir = (double)(2*ir_ksum - (N-1)*ir_sum)/CFG::TWICE_SUM_X2;
+  beta_red = (double)(2*red_ksum - (N-1)*red_sum)/CFG::TWICE_SUM_X2;
+
+  // IR autocorrelation by lag, growing the head/tail partial sums one sample per lag
+  for (n_lag=0; n_lag<LAGS; ++n_lag) {
+    if (n_lag > 0) {
+      int64_t k_head = n_lag-1, k_tail = N-n_lag;
+      int64_t x_head = ir[(n_first + k_head) & MASK];
+      int64_t x_tail = ir[(n_first + k_tail) & MASK];
+      n_head_sum += x_head;
+      n_head_ksum += k_head*x_head;
+      n_tail_sum += x_tail;
+      n_tail_ksum += k_tail*x_tail;
+    }
+    if (n_lag > 0 && n_lag < CFG::AUT_FIRST_LAG) continue; // never read by the searches
+    an_aut[n_lag] = rf_stream_detrended_lag(N, ir_lag[n_lag], ir_sum, ir_ksum, n_lag,
+                                            n_head_sum, n_head_ksum, n_tail_sum, n_tail_ksum, beta_ir)/(N-n_lag);
+  }
+
+  // Mean squares of both AC signals; the pulse detector also needs the IR one as lag 0
+  f_ir_sumsq = an_aut[0];
+  f_red_sumsq = rf_stream_detrended_lag(N, red_sumsq, red_sum, red_ksum, 0, 0, 0, 0, 0, beta_red)/N;
+
+  // Pearson correlation between red and IR: sum(e_x*e_y) expanded like the lag products
+  sum_xy = (double)(N*cross - ir_sum*red_sum)/N
+         - beta_red*(double)(2*ir_ksum - (N-1)*ir_sum)/2.0
+         - beta_ir*(double)(2*red_ksum - (N-1)*red_sum)/2.0
+         + beta_ir*beta_red*(double)CFG::TWICE_SUM_X2/2.0;
+  *correl = (sum_xy/N)/sqrt(f_red_sumsq*f_ir_sumsq);
+
+  rf_finish_from_table(&CFG::PARAMS, an_aut, f_ir_mean, f_red_mean, f_ir_sumsq, f_red_sumsq, *correl,
+                       &n_last_peak_interval, pn_spo2, pch_spo2_valid, pn_heart_rate, pch_hr_valid, ratio);
+#endif
+}
+
+#endif /* ALGORITHM_BY_RF_STREAM_H_ */
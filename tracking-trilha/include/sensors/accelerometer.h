@@ -5,24 +5,83 @@
 #include "hardware/i2c.h"
 #include "sensor.h"
 #include "imu6050.h"
+#include "frame_buffer.h"
+#include "step_counter.h"
+#include "motion_context.h"
 
 #define PIN_WIRE_SDA_ACCEL 0
 #define PIN_WIRE_SCL_ACCEL 1
 #define I2C_PORT_ACCEL i2c0
 
+#define ACCEL_ODR_HZ 100  // IMU6050 FIFO rate, the whole stream reaches the buffers
+
+// Channels of one IMU frame, in IMU6050 register order
+typedef enum imuChannel_t {
+    IMU_CHANNEL_ACCEL_X,
+    IMU_CHANNEL_ACCEL_Y,
+    IMU_CHANNEL_ACCEL_Z,
+    IMU_CHANNEL_TEMP,
+    IMU_CHANNEL_GYRO_X,
+    IMU_CHANNEL_GYRO_Y,
+    IMU_CHANNEL_GYRO_Z,
+    IMU_CHANNEL_QTT
+} imuChannel_t;
+
+// 16 bytes per frame against 28 for seven float samples. The frames are stored once, so
+// the 128 frames take 2 KB, plus the 512 B axisData scratch: 2.5 KB against 7 KB for
+// seven mirrored float SampleBuffers
+typedef FrameBuffer<IMU_CHANNEL_QTT, MAX_BUFFER_SIZE> ImuFrameBuffer;
+typedef ImuFrameBuffer::frame_t imuFrame_t;
+typedef ImuFrameBuffer::view_t imuFrameView_t;
+
 class Accelerometer : public Sensor {
   public:
     Accelerometer();
 
     void Update();
     bool getData(Data_t* data);
+    bool releaseData(Data_t* data);
+    size_t GetSampleTypes(const sample_t** types);
+
+    // Interleaved access to the same frames getData() serves axis by axis, oldest first
+    size_t getFrames(imuFrameView_t* frames);
+    bool releaseFrames();
+    inline float Value(const imuFrame_t& frame, imuChannel_t channel) const { return samples.Value(frame, channel); }
+
+    // Activity of the last second, for the task that calls Update()
+    inline float Cadence() const { return stepCounter.Cadence(); }
+    inline float MotionIntensity() const { return stepCounter.Intensity(); }
+
+    // Magnitude variance over MOTION_WINDOW_MS, readable from any task
+    inline const MotionContext* Motion() const { return &motion; }
   private:
-    float buffer_accel_x[MAX_BUFFER_SIZE];  // Accelerometer X value
-    float buffer_accel_y[MAX_BUFFER_SIZE];  // Accelerometer Y value
-    float buffer_accel_z[MAX_BUFFER_SIZE];  // Accelerometer Z value
-    size_t buffer_size_accel_x = 0;
-    size_t buffer_size_accel_y = 0;
-    size_t buffer_size_accel_z = 0;
+    ImuFrameBuffer samples;  // every channel of a frame is committed at once
+
+    // A read round: the frames acquired by the first getData() are served to every
+    // axis and consumed once each axis was released or one is asked for again
+    imuFrameView_t roundFrames;
+    bool roundActive;
+    uint32_t roundReleased;  // bit per imuChannel_t
+    // Per-axis copy of the round handed out by getData(). Data_t is a contiguous float
+    // array and the frames hold interleaved int16, so the per-axis path costs this copy
+    // (scaled on the way); getFrames() stays zero-copy
+    float axisData[MAX_BUFFER_SIZE];
+
+    static int GetChannel(sample_t type);
+    bool BeginRound();
+    void EndRound();
+
+    imu6050_frame_t fifoFrames[IMU6050_FIFO_MAX_FRAMES];  // one FIFO drain
+
+    // Fed with every frame, published once per Update()
+    StepCounter stepCounter = StepCounter(ACCEL_ODR_HZ);
+    SampleBuffer buffer_steps;  // Steps since boot
+    SampleBuffer buffer_cadence;  // Steps per minute
+    SampleBuffer* GetBuffer(sample_t type);
+
+    MotionContext motion;
+    float motionMean;      // running mean and variance of the magnitude, in g and g^2
+    float motionVariance;
 
     IMU6050 imuSensor = IMU6050(I2C_PORT_ACCEL, PIN_WIRE_SDA_ACCEL, PIN_WIRE_SCL_ACCEL, I2C_SPEED_FAST, MPU_ADDR);
 };
\ No newline at end of file
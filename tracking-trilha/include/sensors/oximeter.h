@@ -1,11 +1,16 @@
 #pragma once 
 
 #include <stdio.h>
+#include <atomic>
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "MAX3010X.h"
 #include "sensor.h"
-#include "algorithm_by_RF.h"
+#include "algorithm_by_RF_stream.h"
+#include "decimator.h"
+#include "ring_buffer.h"
+#include "core_affinity.h"
+#include "motion_context.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
@@ -13,14 +18,58 @@
 #define PIN_WIRE_SDA_OXI 0
 #define PIN_WIRE_SCL_OXI 1
 #define I2C_PORT_OXI i2c0
+#define PIN_INT_OXI 16  // MAX3010X INT output (active low, open drain)
 
 #define MAX3010X_ADDRESS	0x57
-#define BUFFER_SIZE_ALGORITHM 25  // only for algorithm_by_RF.h - reduced for faster processing
 
-// FreeRTOS task configuration
-#define OXIMETER_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
-#define OXIMETER_TASK_STACK_SIZE 2048
-#define OXIMETER_UPDATE_PERIOD_MS 1000  // Update every 1 second
+// Acquisition: the FIFO fills at OXIMETER_SAMPLE_RATE/OXIMETER_SAMPLE_AVERAGE (400 Hz)
+#define OXIMETER_SAMPLE_RATE 1600  // MAX3010X ADC rate, see MAX3010XBase::setup()
+#define OXIMETER_SAMPLE_AVERAGE 4  // samples averaged by the MAX3010X per FIFO entry
+#define OXIMETER_FIFO_RATE (OXIMETER_SAMPLE_RATE / OXIMETER_SAMPLE_AVERAGE)
+
+// HR/SpO2 runs on a OXIMETER_WINDOW_SECONDS window at OXIMETER_RF_RATE
+#define OXIMETER_RF_RATE 25
+#define OXIMETER_WINDOW_SECONDS 1
+#define OXIMETER_DECIMATION (OXIMETER_FIFO_RATE / OXIMETER_RF_RATE)  // FIFO samples per algorithm sample
+#define OXIMETER_DECIMATOR_TAPS 8  // FIR taps per polyphase branch, flat to 8 Hz and -58 dB from 20 Hz at 16x
+#define OXIMETER_HOP_SAMPLES 5  // new algorithm samples between two HR/SpO2 results
+
+typedef RFConfig<OXIMETER_RF_RATE, OXIMETER_WINDOW_SECONDS> OximeterRF;
+typedef Decimator<uint32_t, OXIMETER_DECIMATION, OXIMETER_DECIMATOR_TAPS> OximeterDecimator;
+
+typedef struct {
+    uint32_t ir;
+    uint32_t red;
+} oximeterSample_t;
+
+// Acquisition settings the activity governor switches between at run time. The FIFO
+// rate stays OXIMETER_FIFO_RATE, so decimation and the HR/SpO2 window are untouched.
+typedef struct {
+    uint16_t sampleRate;    // MAX3010X ADC rate, LED pulses per second
+    uint8_t sampleAverage;  // sampleRate / sampleAverage must be OXIMETER_FIFO_RATE
+    uint8_t ledAmplitude;   // 0=Off to 255=50mA
+    uint8_t hopSamples;     // algorithm samples between two HR/SpO2 results
+} oximeterProfile_t;
+
+// FreeRTOS task configuration: the I/O task drains the sensor on CORE_IO and hands raw
+// samples to the DSP task on CORE_DSP
+#define OXIMETER_IO_TASK_PRIORITY (tskIDLE_PRIORITY + 4)
+#define OXIMETER_IO_TASK_STACK_SIZE 1024
+#define OXIMETER_DSP_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+#define OXIMETER_DSP_TASK_STACK_SIZE 2048
+#define OXIMETER_RAW_BUFFER_SIZE 128  // raw FIFO samples in flight between the tasks, 320 ms at 400 Hz
+#define OXIMETER_TEMPERATURE_PERIOD_MS 1000  // die temperature is slow to read, refresh it every 1 second
+#define OXIMETER_INT_TIMEOUT_MS 250  // give up waiting for INT and drain the FIFO anyway
+// FIFO entries waiting when INT fires. A_FULL holds the free slots left in 4 bits, so INT
+// can only fire with 17 to 32 entries: the first level past one algorithm sample
+#define OXIMETER_INT_SAMPLES 17
+
+// Raw FIFO samples, I/O task to DSP task; a full ring drops new samples instead of tearing the window
+typedef RingBuffer<oximeterSample_t, OXIMETER_RAW_BUFFER_SIZE, RING_POLICY_DROP_NEWEST> OximeterRawBuffer;
+
+// Motion gate: above this acceleration spread a window almost never passes the correlation check
+#define OXIMETER_MOTION_GATE_G 0.15f  // standard deviation of the acceleration magnitude
+#define OXIMETER_MOTION_MAX_AGE_MS 500  // older motion context is ignored and the window computed
 
 class Oximeter : public Sensor {
   public:
@@ -29,28 +78,68 @@ class Oximeter : public Sensor {
 
     void Update();
     bool getData(Data_t* data);
+    bool releaseData(Data_t* data);
+    size_t GetSampleTypes(const sample_t** types);
     void StartTask();
     void StopTask();
+
+    // Applied by the I/O task before its next FIFO drain; nullptr keeps the current settings
+    void SetProfile(const oximeterProfile_t* profile);
+    inline float HeartRateDelta() const { return heartRateDelta.load(std::memory_order_relaxed); }
+
+    // Windows with heavy motion are skipped before the periodicity search
+    inline void SetMotionContext(const MotionContext* context) { motion = context; }
+    inline uint32_t SkippedWindows() const { return skippedWindows.load(std::memory_order_relaxed); }
     
   private:
     bool is_valid();
-    static void OximeterTask(void* pvParameters);
-    void UpdateInternal();
+    static void OximeterIOTask(void* pvParameters);
+    static void OximeterDSPTask(void* pvParameters);
+    static void IntHandler();
+    void AcquireSamples();
+    void ProcessSamples();
+    void PublishResult();
+    bool MotionTooHigh();
+
+    // Written by OximeterTask, drained by getData() without a lock
+    SampleBuffer buffer_spO2;  //SPO2 value
+    SampleBuffer buffer_heart_rate;  //Heart rate value
+    SampleBuffer buffer_temperature;  //Temperature value
 
-    float buffer_spO2[MAX_BUFFER_SIZE];  //SPO2 value
-    float buffer_heart_rate[MAX_BUFFER_SIZE];  //Heart rate value
-    float buffer_temperature[MAX_BUFFER_SIZE];  //Temperature value
-    size_t buffer_size_spO2 = 0;
-    size_t buffer_size_heart_rate = 0;
-    size_t buffer_size_temperature = 0;
+    SampleBuffer* GetBuffer(sample_t type);
 
     int8_t ch_spo2_valid;  //indicator to show if the SPO2 calculation is valid
     int32_t n_heart_rate; //heart rate value
     int8_t  ch_hr_valid;  //indicator to show if the heart rate calculation is valid
     float n_spo2;
+    std::atomic<float> temperature;  // refreshed over I2C by the I/O task, published by the DSP task
+    uint32_t lastTemperatureMs;
+
+    OximeterRawBuffer rawSamples;  // I/O task to DSP task
+
+    // Every FIFO sample is low-passed and decimated to OXIMETER_RF_RATE into the sliding HR/SpO2 window
+    OximeterDecimator decimatorIR;
+    OximeterDecimator decimatorRed;
+    RFStream<OximeterRF> stream;
+    uint32_t samplesSinceResult;
+    std::atomic<uint32_t> hopSamples;  // set by the I/O task with the profile
+
+    // Activity governor: requested by any task, applied on the I/O task
+    std::atomic<const oximeterProfile_t*> requestedProfile;
+    const oximeterProfile_t* appliedProfile;
+    void ApplyProfile();
+
+    // HR stability: running mean of the change between consecutive valid results, in bpm
+    std::atomic<float> heartRateDelta;
+    int32_t lastHeartRate;
+
+    const MotionContext* motion;  // nullptr disables the motion gate
+    std::atomic<uint32_t> skippedWindows;
     
     // FreeRTOS task management
-    TaskHandle_t taskHandle;
-    SemaphoreHandle_t dataMutex;
+    TaskHandle_t ioTaskHandle;
+    TaskHandle_t dspTaskHandle;
     bool taskRunning;
+
+    static Oximeter* intTarget;  // instance notified from the INT pin interrupt
 };
@@ -2,6 +2,9 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include "ring_buffer.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
 
 #define MAX_BUFFER_SIZE 128
 
@@ -15,6 +18,12 @@ typedef enum sample_t {
     SAMPLE_TYPE_ACCEL_X,
     SAMPLE_TYPE_ACCEL_Y,
     SAMPLE_TYPE_ACCEL_Z,
+    SAMPLE_TYPE_GYRO_X,
+    SAMPLE_TYPE_GYRO_Y,
+    SAMPLE_TYPE_GYRO_Z,
+    SAMPLE_TYPE_IMU_TEMP,
+    SAMPLE_TYPE_STEPS,
+    SAMPLE_TYPE_CADENCE,
     SAMPLE_TYPE_QTT
 } sample_t;
 
@@ -24,18 +33,38 @@ typedef enum sensor_t {
     SENSOR_TYPE_QTT
 } sensor_t;
 
+// Read-only snapshot returned by getData(). It stays valid until it is handed
+// back with releaseData(); the producer keeps writing meanwhile.
 typedef struct {
     uint64_t timestamp;
-    float *data;
+    const float *data;
     size_t size;
     sample_t type;
 } Data_t;
 
+// Per-sample history kept by every sensor; a slow consumer loses the oldest samples
+typedef RingBuffer<float, MAX_BUFFER_SIZE, RING_POLICY_OVERWRITE_OLDEST> SampleBuffer;
+
 class Sensor {
   public:
+    Sensor() : sensorType(SENSOR_TYPE_QTT), notify(nullptr) {}
+
     virtual void Update() = 0;
     virtual bool getData(Data_t* data) = 0;
+    virtual bool releaseData(Data_t* data) = 0;  // false if the snapshot was overwritten while held
+    virtual size_t GetSampleTypes(const sample_t** types) = 0;  // the samples getData() can serve, fixed per sensor
     virtual inline sensor_t GetType() { return sensorType; }
+
+    // Given by the sensor every time it publishes a block of samples
+    inline void SetNotify(SemaphoreHandle_t semaphore) { notify = semaphore; }
   protected:
+    // Producers call this after pushing a block; the samples themselves stay in the rings
+    inline void Publish() {
+        if (notify != nullptr) {
+            xSemaphoreGive(notify);
+        }
+    }
+
     sensor_t sensorType;
+    SemaphoreHandle_t notify;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STEP_COUNTER_LOW_HZ 0.7f            // band-pass edges around walking and running step rates
+#define STEP_COUNTER_HIGH_HZ 4.0f
+#define STEP_COUNTER_MIN_THRESHOLD_G 0.05f  // peaks below this are handling noise, not steps
+#define STEP_COUNTER_THRESHOLD_RATIO 0.5f   // fraction of the recent step amplitude a peak must reach
+#define STEP_COUNTER_MIN_INTERVAL_MS 250    // 240 steps/min at most
+#define STEP_COUNTER_MAX_INTERVAL_MS 2000   // a longer gap ends the walk
+#define STEP_COUNTER_CONFIRM_STEPS 4        // regular steps needed before a walk starts counting
+
+/**
+ * Streaming step detector over 3-axis acceleration.
+ *
+ * Each sample costs a magnitude, one biquad band-pass and a few comparisons, and
+ * the state is a handful of scalars, so Push() is O(1) time and memory.
+ *
+ * The band-pass removes gravity and the fast impacts from the vector magnitude. A
+ * step is a local maximum above an adaptive threshold, at least
+ * STEP_COUNTER_MIN_INTERVAL_MS after the previous one. Isolated bumps are not
+ * counted: steps are held back until STEP_COUNTER_CONFIRM_STEPS have arrived at
+ * most STEP_COUNTER_MAX_INTERVAL_MS apart, then all of them are credited. Cadence
+ * is an exponential average of the step interval and drops to 0 when the walk
+ * ends. Intensity() tells how much the wearer moves even when no step is found.
+ */
+class StepCounter {
+  public:
+    explicit StepCounter(float sampleRateHz);
+
+    void Reset();
+    bool Push(float x, float y, float z);  // acceleration in g; true when a step was credited
+
+    inline uint32_t Steps() const { return steps; }
+    float Cadence() const;                 // steps per minute
+    float Intensity() const;               // RMS of the band-passed magnitude over about 1 s, in g
+
+  private:
+    // Band-pass biquad, direct form I
+    float b0, b2, a1, a2;
+    float x1, x2, y1, y2;
+
+    float sampleRate;
+    uint32_t minInterval;    // STEP_COUNTER_*_INTERVAL_MS in samples
+    uint32_t maxInterval;
+
+    float previous;          // last two filtered samples, to spot local maxima
+    float beforePrevious;
+    float peakAverage;       // recent step amplitude, drives the threshold
+    float peakDecay;         // per-sample decay of peakAverage while no step comes
+    float energy;            // running mean of the squared band-passed magnitude
+    float energyAlpha;
+
+    uint32_t sinceStep;      // samples since the last step, saturates past maxInterval
+    bool walking;
+    uint32_t pending;        // steps waiting for the walk to be confirmed, 0 with no step in reach
+    float intervalAverage;   // samples between steps
+    uint32_t steps;
+};
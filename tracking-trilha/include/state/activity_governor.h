@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include "oximeter.h"
+
+// Activity thresholds; a profile is entered when any of its inputs reaches them
+#define GOVERNOR_WALK_CADENCE 60.0f        // steps per minute
+#define GOVERNOR_RUN_CADENCE 140.0f
+#define GOVERNOR_WALK_INTENSITY_G 0.05f    // RMS of the band-passed acceleration magnitude
+#define GOVERNOR_RUN_INTENSITY_G 0.5f
+#define GOVERNOR_HR_UNSTABLE_BPM 5.0f      // mean HR change between results that keeps at least WALKING
+#define GOVERNOR_HOLD_MS 5000              // a lower profile must be wanted this long before switching down
+
+typedef enum activityProfileId_t {
+    ACTIVITY_PROFILE_REST,
+    ACTIVITY_PROFILE_WALKING,
+    ACTIVITY_PROFILE_RUNNING,
+    ACTIVITY_PROFILE_QTT
+} activityProfileId_t;
+
+typedef struct {
+    const char* name;
+    oximeterProfile_t oximeter;  // LED current, ADC rate and HR/SpO2 result rate
+    uint32_t statePeriodMs;      // StateTask and AnalysisTask period
+} activityProfile_t;
+
+/**
+ * Picks the acquisition profile from the wearer's recent activity.
+ *
+ * Cadence and motion intensity come from the accelerometer step counter, HR
+ * stability from the oximeter. More activity means more motion artifacts and
+ * faster changing values, so the governor switches up to a profile with more LED
+ * current and more frequent results right away. Switching down waits until the
+ * lower profile has been wanted for GOVERNOR_HOLD_MS, so a short stop at a
+ * crossing does not make the profile bounce. Every transition is logged.
+ */
+class ActivityGovernor {
+  public:
+    ActivityGovernor();
+
+    // Called once per state tick; returns true when the profile changed
+    bool Update(uint32_t nowMs, float cadence, float intensity, float heartRateDelta);
+
+    inline const activityProfile_t* Profile() const { return &profiles[current]; }
+    inline activityProfileId_t ProfileId() const { return current; }
+    inline uint32_t Transitions() const { return transitions; }
+
+    static const activityProfile_t profiles[ACTIVITY_PROFILE_QTT];
+
+  private:
+    activityProfileId_t current;
+    bool lowering;          // a lower profile is wanted since lowerSinceMs
+    uint32_t lowerSinceMs;
+    uint32_t transitions;
+};
@@ -6,6 +6,8 @@
 #include "utils.h"
 #include "analyzer.h"
 
+#define STATE_MAX_ANALYZERS_PER_SAMPLE 2  // analyzers allowed on one (sensor, sample) pair
+
 class State {
 public:
     State();
@@ -16,17 +18,23 @@ public:
 
     virtual ~State();
 
+    // Registration reports every rejected entry; call Validate() once everything is added
     virtual bool AddSensor(Sensor* sensor);
     virtual Sensor* GetSensor(sensor_t type);
 
     virtual bool AddAnalyzer(Analyzer* analyzer);
     virtual Analyzer* GetAnalyzer(sensor_t type, sample_t sampleType);
+    size_t GetAnalyzers(sensor_t type, sample_t sampleType, Analyzer* const** analyzers);
+    bool Validate();
 
     inline bool PopRequested() const { return popRequested; }
     inline bool QuitRequested() const { return quitRequested; }
 protected:
+    // Direct-indexed by type: dispatch never scans
     Sensor* sensorArray[SENSOR_TYPE_QTT];
-    Analyzer* analyzerArray[SENSOR_TYPE_QTT];
+    Analyzer* analyzerTable[SENSOR_TYPE_QTT][SAMPLE_TYPE_QTT][STATE_MAX_ANALYZERS_PER_SAMPLE];
+    uint8_t analyzerCount[SENSOR_TYPE_QTT][SAMPLE_TYPE_QTT];
+    size_t rejected;  // registrations refused since construction
 
     bool popRequested;
     bool quitRequested;
@@ -5,11 +5,50 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "semphr.h"
+#include "queue.h"
+#include "ring_buffer.h"
+#include "core_affinity.h"
+#include "activity_governor.h"
+#include <atomic>
 
-// FreeRTOS task configuration for StateCollect
-#define STATE_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+// FreeRTOS task configuration for StateCollect: StateTask polls the bus sensors, prints
+// to USB and composes the OLED frame on CORE_IO (the Oled display task flushes it);
+// AnalysisTask runs the analyzers on CORE_DSP. Both block until there is something
+// to do: AnalysisTask on the sensors' publish semaphores through a queue set,
+// StateTask on the reports semaphore or its next sensor poll.
+#define STATE_TASK_PRIORITY (tskIDLE_PRIORITY + 2)  // above the Oled display task
 #define STATE_TASK_STACK_SIZE 2048
-#define STATE_UPDATE_PERIOD_MS 100  // Update every 100ms
+#define STATE_ANALYSIS_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+#define STATE_ANALYSIS_TASK_STACK_SIZE 1024
+#define STATE_UPDATE_PERIOD_MS 100  // poll the bus sensors every 100ms until the governor picks a profile
+#define STATE_MAX_UPDATE_PERIOD_MS 500  // longest period a governor profile may ask for
+#define STATE_REPORT_BUFFER_SIZE 16  // analysis results waiting to be printed, power of two
+#define STATE_OLED_SAMPLE_LINES 6  // OLED lines 1..6 show the first wanted samples
+
+// One sample a registered sensor really produces and StateCollect wants, resolved
+// once at startup so the analysis loop never asks a sensor for a foreign sample
+typedef struct {
+    sample_t sampleType;
+    uint8_t sampleIndex;         // position in wanted_samples, selects the OLED line
+    uint8_t analyzerCount;
+    Analyzer* const* analyzers;  // row of the State analyzer table
+} stateSubscription_t;
+
+// One analyzed snapshot, handed from AnalysisTask to StateTask
+typedef struct {
+    sensor_t sensorType;
+    sample_t sampleType;
+    size_t sampleIndex;  // position in wanted_samples, selects the OLED line
+    float first;         // oldest value of the snapshot
+    float last;          // newest value of the snapshot
+    size_t size;
+    healthStatus_t healthStatus;
+    bool analyzed;       // an analyzer exists for this sample
+    bool overwritten;    // the producer overwrote the snapshot while it was analyzed
+} stateReport_t;
+
+// Reports from AnalysisTask (CORE_DSP) to StateTask (CORE_IO); a full ring drops the new report
+typedef RingBuffer<stateReport_t, STATE_REPORT_BUFFER_SIZE, RING_POLICY_DROP_NEWEST> StateReportBuffer;
 
 class StateCollect : public State {
 public:
@@ -32,9 +71,39 @@ private:
 
   void PrintOled(int line_index, const char* text);
   void UpdateInternal();
+  void PollSensors();
+  bool ShowReports();
+  void AnalyzeInternal();
+  void AnalyzeSensor(sensor_t sensor_type);
+  bool CreateEvents();
+  void BuildSubscriptions();
+  bool HasPolledSensors();
+  void PrintReport(const stateReport_t* report);
+  void RunGovernor();
   static void StateTask(void* pvParameters);
+  static void AnalysisTask(void* pvParameters);
+
+  // AnalysisTask -> StateTask; a full ring drops the newest reports
+  StateReportBuffer reports;
   
+  // Picks the sensor and task settings from the wearer's activity, on StateTask
+  ActivityGovernor governor;
+  std::atomic<uint32_t> periodMs;  // StateTask sensor polling period
+
+  // Flat subscription table: sensor -> [first, first + count) -> sample, analyzers, OLED line
+  stateSubscription_t subscriptions[SAMPLE_TYPE_QTT];
+  uint8_t subscriptionFirst[SENSOR_TYPE_QTT];
+  uint8_t subscriptionCount[SENSOR_TYPE_QTT];
+  size_t subscriptionTotal;
+  bool subscribed;  // built by the first StartTask() or Update(); register everything before
+
+  // Sensor publish -> AnalysisTask -> StateTask wake-ups
+  QueueSetHandle_t sensorSet;
+  SemaphoreHandle_t sensorReady[SENSOR_TYPE_QTT];
+  SemaphoreHandle_t reportsReady;
+
   // FreeRTOS task management
   TaskHandle_t taskHandle;
+  TaskHandle_t analysisTaskHandle;
   bool taskRunning;
 };
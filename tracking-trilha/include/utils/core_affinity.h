@@ -0,0 +1,20 @@
+#pragma once
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+// Core assignment policy. Tasks that talk to the I2C buses, the OLED or USB
+// stdio live on CORE_IO; tasks that only crunch numbers live on CORE_DSP and
+// exchange data with the I/O side through lock-free RingBuffers.
+#define CORE_IO     0
+#define CORE_DSP    1
+
+// Pin a task to one core. A no-op on single-core builds, where every task shares core 0.
+inline void PinTaskToCore(TaskHandle_t task, UBaseType_t core) {
+#if configNUMBER_OF_CORES > 1 && configUSE_CORE_AFFINITY
+    vTaskCoreAffinitySet(task, (UBaseType_t)1 << core);
+#else
+    (void)task;
+    (void)core;
+#endif
+}
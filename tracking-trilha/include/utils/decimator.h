@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <limits>
+
+/**
+ * Streaming polyphase FIR decimator.
+ *
+ * Low-pass filters a stream with a FACTOR * TAPS_PER_PHASE tap windowed-sinc
+ * FIR and keeps one output every FACTOR inputs. Only the kept outputs are
+ * computed: each input is multiplied by its polyphase branch (TAPS_PER_PHASE
+ * Q15 taps) into the TAPS_PER_PHASE outputs it contributes to, so the cost is
+ * TAPS_PER_PHASE multiply-accumulates per input sample and no input history is
+ * stored. Gain at DC is exactly 1.
+ *
+ * The first TAPS_PER_PHASE - 1 outputs only see part of the filter span and
+ * are swallowed, so the consumer never gets the start-up transient.
+ */
+template <typename T, size_t FACTOR, size_t TAPS_PER_PHASE>
+class Decimator {
+    static_assert(FACTOR >= 2 && TAPS_PER_PHASE >= 1, "Decimator needs a factor of at least 2 and one tap per phase");
+    static_assert(std::numeric_limits<T>::is_integer && sizeof(T) <= 4, "Decimator filters integer samples of up to 32 bits");
+
+  public:
+    static constexpr size_t TAPS = FACTOR * TAPS_PER_PHASE;
+
+    // cutoff is the -6 dB point in cycles per input sample, the output Nyquist by default
+    explicit Decimator(float cutoff = 0.5f / FACTOR);
+
+    void Reset();
+    bool Push(T in, T* out);                          // true when out holds a new output sample
+    size_t Process(const T* in, size_t count, T* out); // returns outputs written, at most count / FACTOR + 1
+
+    static constexpr size_t Factor() { return FACTOR; }
+    static constexpr size_t Delay() { return (TAPS - 1) / 2; }  // group delay in input samples
+
+  private:
+    int16_t phase[FACTOR][TAPS_PER_PHASE];  // phase[r][k] = h[k * FACTOR + FACTOR - 1 - r]
+    int64_t acc[TAPS_PER_PHASE];            // partial outputs, acc[slot] completes next
+    size_t slot;
+    size_t input;                           // position of the next input within its block
+    size_t warmup;                          // outputs still to swallow
+};
+
+template <typename T, size_t FACTOR, size_t TAPS_PER_PHASE>
+Decimator<T, FACTOR, TAPS_PER_PHASE>::Decimator(float cutoff) {
+    // Hamming windowed sinc, quantized to Q15 with the rounding error folded into the centre tap
+    float h[TAPS];
+    float sum = 0.0f;
+    for (size_t j = 0; j < TAPS; j++) {
+        float t = (float)j - (TAPS - 1) / 2.0f;
+        float sinc = (t == 0.0f) ? 2.0f * cutoff : sinf(2.0f * (float)M_PI * cutoff * t) / ((float)M_PI * t);
+        float window = (TAPS > 1) ? 0.54f - 0.46f * cosf(2.0f * (float)M_PI * j / (TAPS - 1)) : 1.0f;
+        h[j] = sinc * window;
+        sum += h[j];
+    }
+
+    int32_t total = 0;
+    for (size_t j = 0; j < TAPS; j++) {
+        int32_t q = (int32_t)lroundf(h[j] / sum * 32768.0f);
+        phase[FACTOR - 1 - j % FACTOR][j / FACTOR] = (int16_t)q;
+        total += q;
+    }
+    size_t centre = (TAPS - 1) / 2;
+    phase[FACTOR - 1 - centre % FACTOR][centre / FACTOR] += (int16_t)(32768 - total);
+
+    Reset();
+}
+
+template <typename T, size_t FACTOR, size_t TAPS_PER_PHASE>
+void Decimator<T, FACTOR, TAPS_PER_PHASE>::Reset() {
+    for (size_t k = 0; k < TAPS_PER_PHASE; k++) {
+        acc[k] = 0;
+    }
+    slot = 0;
+    input = 0;
+    warmup = TAPS_PER_PHASE - 1;
+}
+
+template <typename T, size_t FACTOR, size_t TAPS_PER_PHASE>
+bool Decimator<T, FACTOR, TAPS_PER_PHASE>::Push(T in, T* out) {
+    const int16_t* taps = phase[input];
+    int64_t x = in;
+
+    // Input r of block m feeds outputs m .. m + TAPS_PER_PHASE - 1
+    size_t s = slot;
+    for (size_t k = 0; k < TAPS_PER_PHASE; k++) {
+        acc[s] += taps[k] * x;
+        if (++s == TAPS_PER_PHASE) {
+            s = 0;
+        }
+    }
+
+    if (++input < FACTOR) {
+        return false;
+    }
+    input = 0;
+
+    // Output m has all its inputs now; its accumulator starts over as output m + TAPS_PER_PHASE
+    int64_t y = (acc[slot] + (1 << 14)) >> 15;
+    acc[slot] = 0;
+    if (++slot == TAPS_PER_PHASE) {
+        slot = 0;
+    }
+
+    if (warmup > 0) {
+        warmup--;
+        return false;
+    }
+
+    if (y < (int64_t)std::numeric_limits<T>::min()) {
+        y = std::numeric_limits<T>::min();
+    } else if (y > (int64_t)std::numeric_limits<T>::max()) {
+        y = std::numeric_limits<T>::max();
+    }
+    *out = (T)y;
+    return true;
+}
+
+template <typename T, size_t FACTOR, size_t TAPS_PER_PHASE>
+size_t Decimator<T, FACTOR, TAPS_PER_PHASE>::Process(const T* in, size_t count, T* out) {
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (Push(in[i], &out[written])) {
+            written++;
+        }
+    }
+    return written;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ring_buffer.h"
+
+// One multi-channel reading, all channels taken at the same instant
+template <size_t CHANNELS>
+struct Frame {
+    uint16_t timestamp;         // ms since boot, low 16 bits; orders and spaces frames within a window
+    int16_t channel[CHANNELS];  // raw readings, value = raw * scale + offset
+};
+
+/**
+ * Ring of interleaved frames from one multi-channel sensor.
+ *
+ * Every channel of a frame is committed by a single Push(), so readers never see
+ * one channel ahead of another. Samples stay in their raw int16 form and are
+ * converted with a per-channel scale and offset only when read, which keeps a
+ * frame of CHANNELS readings in 2 + 2 * CHANNELS bytes instead of 4 * CHANNELS.
+ *
+ * Frames are stored once (RING_LAYOUT_SPLIT), so N frames take N * sizeof(frame_t).
+ * Readers take a zero-copy interleaved view with Acquire(), in two spans when it
+ * wraps, and either walk the frames directly (view[i], Value()) or deinterleave one
+ * channel into a float array with CopyChannel(). Same single-producer/single-consumer
+ * rules as RingBuffer.
+ */
+template <size_t CHANNELS, size_t N>
+class FrameBuffer {
+  public:
+    typedef Frame<CHANNELS> frame_t;
+    typedef RingSpans<frame_t> view_t;
+
+    FrameBuffer() {
+        for (size_t c = 0; c < CHANNELS; c++) {
+            scale[c] = 1.0f;
+            offset[c] = 0.0f;
+        }
+    }
+
+    // Set before the producer starts
+    inline void SetScale(size_t c, float channelScale, float channelOffset = 0.0f) {
+        scale[c] = channelScale;
+        offset[c] = channelOffset;
+    }
+
+    // Producer side
+    inline bool Push(uint32_t timestampMs, const int16_t* raw) {
+        frame_t frame;
+        frame.timestamp = (uint16_t)timestampMs;
+        for (size_t c = 0; c < CHANNELS; c++) {
+            frame.channel[c] = raw[c];
+        }
+        return frames.Push(frame);
+    }
+
+    // Consumer side
+    inline size_t Acquire(view_t* view) { return frames.Acquire(view); }
+    inline bool Release(size_t count) { return frames.Release(count); }
+    inline bool Intact() const { return frames.Intact(); }
+    inline size_t Size() const { return frames.Size(); }
+
+    inline float Value(const frame_t& frame, size_t c) const { return frame.channel[c] * scale[c] + offset[c]; }
+
+    // Per-channel layout of an acquired view
+    size_t CopyChannel(const view_t& view, size_t c, float* out) const {
+        for (size_t i = 0; i < view.firstSize; i++) {
+            out[i] = Value(view.first[i], c);
+        }
+        for (size_t i = 0; i < view.secondSize; i++) {
+            out[view.firstSize + i] = Value(view.second[i], c);
+        }
+        return view.Size();
+    }
+
+    static constexpr size_t Capacity() { return N; }
+    static constexpr size_t Channels() { return CHANNELS; }
+
+  private:
+    RingBuffer<frame_t, N, RING_POLICY_OVERWRITE_OLDEST, RING_LAYOUT_SPLIT> frames;
+    float scale[CHANNELS];
+    float offset[CHANNELS];
+};
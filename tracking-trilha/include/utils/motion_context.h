@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#define MOTION_WINDOW_MS 1000  // span the published variance covers, the HR/SpO2 window
+
+/**
+ * Latest motion level of the wearer, shared between tasks without a lock.
+ *
+ * The accelerometer publishes the variance of its acceleration magnitude over
+ * about MOTION_WINDOW_MS once per update. Readers on any core get the last
+ * value and its age in two atomic loads, so they never wait on the producer.
+ */
+class MotionContext {
+  public:
+    MotionContext() : variance(0.0f), updatedMs(0) {}
+
+    inline void Publish(float magnitudeVariance, uint32_t nowMs) {
+        variance.store(magnitudeVariance, std::memory_order_relaxed);
+        updatedMs.store(nowMs, std::memory_order_release);
+    }
+
+    // false when nothing was published in the last maxAgeMs
+    inline bool Read(uint32_t nowMs, uint32_t maxAgeMs, float* magnitudeVariance) const {
+        uint32_t published = updatedMs.load(std::memory_order_acquire);
+        if (published == 0 || nowMs - published > maxAgeMs) {
+            return false;
+        }
+        *magnitudeVariance = variance.load(std::memory_order_relaxed);
+        return true;
+    }
+
+  private:
+    std::atomic<float> variance;     // g^2
+    std::atomic<uint32_t> updatedMs;
+};
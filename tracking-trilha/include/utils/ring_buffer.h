@@ -0,0 +1,235 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// What Push() does when the ring is full
+typedef enum ring_policy_t {
+    RING_POLICY_OVERWRITE_OLDEST,  // newest sample wins, consumer loses the oldest ones
+    RING_POLICY_DROP_NEWEST        // stored samples win, the new one is discarded
+} ring_policy_t;
+
+// How the elements sit in memory
+typedef enum ring_layout_t {
+    RING_LAYOUT_MIRRORED,  // stored twice, every unread run is contiguous: 2 * N elements
+    RING_LAYOUT_SPLIT      // stored once, an unread run may wrap into two spans: N elements
+} ring_layout_t;
+
+// Unread run of a ring as at most two contiguous spans, oldest first
+template <typename T>
+struct RingSpans {
+    const T* first;
+    size_t firstSize;
+    const T* second;   // continues first after the wrap, empty when the run did not wrap
+    size_t secondSize;
+
+    inline size_t Size() const { return firstSize + secondSize; }
+    inline const T& operator[](size_t i) const { return i < firstSize ? first[i] : second[i - firstSize]; }
+};
+
+/**
+ * Fixed-capacity single-producer/single-consumer ring buffer.
+ *
+ * head is written only by the producer and tail only by the consumer. Both are
+ * free-running counters, so the fill level is always head - tail and push/pop are
+ * O(1) with no lock. In overwrite mode the producer never touches tail; it
+ * announces the slot it is about to write through `claimed` and the consumer
+ * uses that, seqlock style, to drop samples overwritten while it was copying.
+ *
+ * In the mirrored layout every element is stored twice (at i and i + N), so any
+ * run of up to N unread elements is contiguous in memory. Acquire() hands that
+ * run out as a read-only view without copying and Release() tells the consumer
+ * whether the producer overwrote any of it in the meantime. The split layout
+ * stores every element once, for half the RAM, and hands the same run out as two
+ * spans instead. In drop-newest mode a held view is never overwritten; in
+ * overwrite mode the producer never waits for the consumer.
+ */
+template <typename T, size_t N, ring_policy_t POLICY = RING_POLICY_OVERWRITE_OLDEST, ring_layout_t LAYOUT = RING_LAYOUT_MIRRORED>
+class RingBuffer {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "RingBuffer elements are copied with memcpy");
+
+  public:
+    RingBuffer() : head(0), claimed(0), tail(0), droppedNewest(0), overrunOldest(0) {}
+
+    // Producer side
+    bool Push(const T& value);
+
+    // Consumer side
+    bool Pop(T* value);
+    size_t ReadAll(T* out, size_t max);  // everything pushed since the last read, oldest first
+    size_t Acquire(const T** data);      // zero-copy view of the same, tail is not moved; mirrored layout only
+    size_t Acquire(RingSpans<T>* spans); // the same view in two spans, either layout
+    bool Release(size_t count);          // consume an acquired view, false if it was overwritten
+    bool Intact() const;                 // the acquired view has not been overwritten so far
+
+    size_t Size() const;
+    inline bool Empty() const { return Size() == 0; }
+    inline uint32_t Dropped() const { return droppedNewest.load(std::memory_order_relaxed) + overrunOldest.load(std::memory_order_relaxed); }
+    static constexpr size_t Capacity() { return N; }
+
+  private:
+    static constexpr uint32_t MASK = N - 1;
+
+    uint32_t FirstReadable(uint32_t t, uint32_t h);
+    size_t Discard(T* out, size_t count, uint32_t* t);
+
+    static constexpr size_t STORAGE = LAYOUT == RING_LAYOUT_MIRRORED ? 2 * N : N;
+
+    T storage[STORAGE];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> claimed;  // head + 1 while the producer is writing a slot
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> droppedNewest;  // written by the producer only
+    std::atomic<uint32_t> overrunOldest;  // written by the consumer only
+};
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+bool RingBuffer<T, N, POLICY, LAYOUT>::Push(const T& value) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+
+    if (POLICY == RING_POLICY_DROP_NEWEST && h - tail.load(std::memory_order_acquire) >= N) {
+        droppedNewest.store(droppedNewest.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (POLICY == RING_POLICY_OVERWRITE_OLDEST) {
+        claimed.store(h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    storage[h & MASK] = value;
+    if (LAYOUT == RING_LAYOUT_MIRRORED) {
+        storage[(h & MASK) + N] = value;
+    }
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+bool RingBuffer<T, N, POLICY, LAYOUT>::Pop(T* value) {
+    return ReadAll(value, 1) == 1;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+size_t RingBuffer<T, N, POLICY, LAYOUT>::ReadAll(T* out, size_t max) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+
+    t = FirstReadable(t, h);
+
+    size_t count = h - t;
+    if (count > max) {
+        count = max;
+    }
+
+    size_t first = count;
+    if (LAYOUT == RING_LAYOUT_SPLIT && (t & MASK) + count > N) {
+        first = N - (t & MASK);
+        memcpy(out + first, &storage[0], (count - first) * sizeof(T));
+    }
+    memcpy(out, &storage[t & MASK], first * sizeof(T));
+
+    if (POLICY == RING_POLICY_OVERWRITE_OLDEST) {
+        count = Discard(out, count, &t);
+    }
+
+    tail.store(t + count, std::memory_order_release);
+    return count;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+size_t RingBuffer<T, N, POLICY, LAYOUT>::Acquire(const T** data) {
+    static_assert(LAYOUT == RING_LAYOUT_MIRRORED, "A split RingBuffer hands out views as RingSpans");
+    RingSpans<T> spans;
+    size_t count = Acquire(&spans);
+    *data = spans.first;
+    return count;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+size_t RingBuffer<T, N, POLICY, LAYOUT>::Acquire(RingSpans<T>* spans) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+
+    uint32_t first = FirstReadable(t, h);
+    if (first != t) {
+        tail.store(first, std::memory_order_release);
+    }
+
+    size_t count = h - first;
+    spans->first = &storage[first & MASK];
+    spans->firstSize = count;
+    spans->second = &storage[0];
+    spans->secondSize = 0;
+    if (LAYOUT == RING_LAYOUT_SPLIT && (first & MASK) + count > N) {
+        spans->firstSize = N - (first & MASK);
+        spans->secondSize = count - spans->firstSize;
+    }
+    return count;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+bool RingBuffer<T, N, POLICY, LAYOUT>::Release(size_t count) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    bool intact = true;
+
+    if (POLICY == RING_POLICY_OVERWRITE_OLDEST) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        int32_t torn = (int32_t)(claimed.load(std::memory_order_relaxed) - N - t);
+        if (torn > 0) {
+            overrunOldest.store(overrunOldest.load(std::memory_order_relaxed) + ((size_t)torn < count ? torn : count), std::memory_order_relaxed);
+            intact = false;
+        }
+    }
+
+    tail.store(t + count, std::memory_order_release);
+    return intact;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+bool RingBuffer<T, N, POLICY, LAYOUT>::Intact() const {
+    if (POLICY == RING_POLICY_OVERWRITE_OLDEST) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (int32_t)(claimed.load(std::memory_order_relaxed) - N - tail.load(std::memory_order_relaxed)) <= 0;
+    }
+    return true;
+}
+
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+size_t RingBuffer<T, N, POLICY, LAYOUT>::Size() const {
+    uint32_t size = head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    return size > N ? N : size;
+}
+
+// Skip samples the producer has already lapped (overwrite mode only)
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+uint32_t RingBuffer<T, N, POLICY, LAYOUT>::FirstReadable(uint32_t t, uint32_t h) {
+    if (POLICY == RING_POLICY_OVERWRITE_OLDEST && h - t > N) {
+        overrunOldest.store(overrunOldest.load(std::memory_order_relaxed) + (h - t - N), std::memory_order_relaxed);
+        t = h - N;
+    }
+    return t;
+}
+
+// After copying, drop whatever the producer overwrote while we were reading.
+// Writing sequence s clobbers sequence s - N, so everything below claimed - N
+// may be torn.
+template <typename T, size_t N, ring_policy_t POLICY, ring_layout_t LAYOUT>
+size_t RingBuffer<T, N, POLICY, LAYOUT>::Discard(T* out, size_t count, uint32_t* t) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t firstValid = claimed.load(std::memory_order_relaxed) - N;
+    int32_t torn = (int32_t)(firstValid - *t);
+    if (torn <= 0) {
+        return count;
+    }
+    if ((size_t)torn > count) {
+        torn = count;
+    }
+    memmove(out, out + torn, (count - torn) * sizeof(T));
+    overrunOldest.store(overrunOldest.load(std::memory_order_relaxed) + torn, std::memory_order_relaxed);
+    *t += torn;
+    return count - torn;
+}
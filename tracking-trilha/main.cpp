@@ -19,12 +19,16 @@ int main(void) {
     StateCollect stateCollect;
     Oximeter oximeter = Oximeter();
     Accelerometer accelerometer = Accelerometer();
+    oximeter.SetMotionContext(accelerometer.Motion());
 
 
     analyzerConfig_t accelerometerConfig = {
         .thresholds = {0.0f, 0.5f, 0.75f, 1.2f, 1.5f},
         .sensorType = SENSOR_TYPE_ACCELEROMETER,
-        .sampleType = SAMPLE_TYPE_ACCEL_X
+        .sampleType = SAMPLE_TYPE_ACCEL_X,
+        .hysteresis = 0.05f,
+        .dwellSamples = 10,
+        .ewmaAlpha = 0.05f
     };
 
     Analyzer accelerometerAnalyzer = Analyzer(accelerometerConfig);
@@ -32,7 +36,10 @@ int main(void) {
     analyzerConfig_t oximeterConfig = {
         .thresholds = {0.0f, 90.0f, 98.0f, 200.0f, 200.0f},
         .sensorType = SENSOR_TYPE_OXIMETER,
-        .sampleType = SAMPLE_TYPE_SPO2
+        .sampleType = SAMPLE_TYPE_SPO2,
+        .hysteresis = 1.0f,
+        .dwellSamples = 2,
+        .ewmaAlpha = 0.2f
     };
     
     Analyzer oximeterAnalyzer = Analyzer(oximeterConfig);
@@ -40,7 +47,10 @@ int main(void) {
     analyzerConfig_t heartRateConfig = {
         .thresholds = {0.0f, 60.0f, 100.0f, 140.0f, 180.0f},
         .sensorType = SENSOR_TYPE_OXIMETER,
-        .sampleType = SAMPLE_TYPE_HEART_RATE
+        .sampleType = SAMPLE_TYPE_HEART_RATE,
+        .hysteresis = 3.0f,
+        .dwellSamples = 2,
+        .ewmaAlpha = 0.2f
     };
 
     Analyzer heartRateAnalyzer = Analyzer(heartRateConfig);
@@ -53,12 +63,20 @@ int main(void) {
 
     stateCollect.AddAnalyzer(&heartRateAnalyzer);
 
+    if (!stateCollect.Validate()) {
+        printf("Sensor/analyzer registration incomplete, see above\n");
+    }
+
     Oled oled;
 
     oled.Clear();
 
     stateCollect.setOled(&oled);
 
+    // Start the display task; StateTask only composes frames from here on
+    printf("Starting display task...\n");
+    oled.StartTask();
+
     // Start the oximeter task
     sleep_ms(1000);
     printf("Starting oximeter task...\n");
@@ -1,19 +1,96 @@
 #include "analyzer.h"
 
 Analyzer::Analyzer(analyzerConfig_t config) : config(config) {
+  for (size_t j = 1; j < HEALTH_STATUS_CRITICAL_HIGH + 1; j++) {
+    if (config.thresholds[j] < config.thresholds[j - 1]) {
+      printf("Analyzer for sensor %d sample %d: thresholds must be ascending\n", config.sensorType, config.sampleType);
+      break;
+    }
+  }
+  if (this->config.ewmaAlpha <= 0.0f || this->config.ewmaAlpha > 1.0f) {
+    this->config.ewmaAlpha = ANALYZER_DEFAULT_EWMA_ALPHA;
+  }
+  if (this->config.hysteresis < 0.0f) {
+    this->config.hysteresis = 0.0f;
+  }
+  Reset();
+}
+
+void Analyzer::Reset() {
+  state.status = HEALTH_STATUS_NORMAL;
+  state.candidate = HEALTH_STATUS_NORMAL;
+  state.candidateSamples = 0;
+  state.stats.min = 0.0f;
+  state.stats.max = 0.0f;
+  state.stats.mean = 0.0f;
+  state.stats.ewma = 0.0f;
+  state.stats.last = 0.0f;
+  state.stats.count = 0;
+  pending = state;
+}
+
+// Number of thresholds above the lowest one the value reaches. Only called for values at or
+// above thresholds[0]; anything below it is not classified, as before
+healthStatus_t Analyzer::Classify(float value) const {
+  const float* t = config.thresholds;
+  return (healthStatus_t)((value >= t[1]) + (value >= t[2]) + (value >= t[3]) + (value >= t[4]));
+}
+
+void Analyzer::Accumulate(float value) {
+  analyzerStats_t& stats = pending.stats;
+  if (stats.count == 0) {
+    stats.min = stats.max = stats.mean = stats.ewma = value;
+  } else {
+    if (value < stats.min) stats.min = value;
+    if (value > stats.max) stats.max = value;
+    stats.ewma += config.ewmaAlpha * (value - stats.ewma);
+  }
+  stats.last = value;
+  stats.count++;
 }
 
 healthStatus_t Analyzer::Analyze(Data_t* data) {
-  healthStatus_t healthStatus = HEALTH_STATUS_NORMAL;
+  pending = state;
+  healthStatus_t& status = pending.status;
+  healthStatus_t& candidate = pending.candidate;
+  uint32_t& candidateSamples = pending.candidateSamples;
+  float sum = 0.0f;  // the mean takes one division per call, not per sample
 
   for (size_t i = 0; i < data->size; i++) {
-    for (size_t j = 0; j < HEALTH_STATUS_CRITICAL_HIGH + 1; j++) {
-      if (data->data[i] < config.thresholds[j]) {
-        break;
-      }
-      healthStatus = (healthStatus_t)j;
+    float value = data->data[i];
+    Accumulate(value);
+    sum += value;
+
+    // Below the lowest threshold the sample is outside the scale: it neither confirms nor breaks a change
+    if (value < config.thresholds[0]) {
+      continue;
+    }
+
+    healthStatus_t raw = Classify(value);
+    if (raw == status) {
+      candidateSamples = 0;
+      continue;
+    }
+
+    // Only a sample that clears the edge by the hysteresis counts towards a change
+    healthStatus_t next = Classify(raw > status ? value - config.hysteresis : value + config.hysteresis);
+    if (next == status) {
+      candidateSamples = 0;
+      continue;
+    }
+
+    if (next != candidate) {
+      candidate = next;
+      candidateSamples = 0;
+    }
+    if (++candidateSamples >= config.dwellSamples) {
+      status = candidate;
+      candidateSamples = 0;
     }
   }
 
-  return healthStatus;
-}
\ No newline at end of file
+  if (data->size > 0) {
+    pending.stats.mean += (sum - data->size * pending.stats.mean) / pending.stats.count;
+  }
+  return status;
+}
@@ -1,7 +1,23 @@
 #include "oled.h"
+#include "core_affinity.h"
 
 Oled::Oled() {
   init_OLed();
+
+  frontLock = nullptr;
+  framePending = false;
+  frameTimeUs = 0;
+  maxFrameTimeUs = 0;
+  flushedFrames = 0;
+  droppedFrames = 0;
+
+  // Initialize FreeRTOS components
+  taskHandle = nullptr;
+  taskRunning = false;
+}
+
+Oled::~Oled() {
+  StopTask();
 }
 
 void Oled::Clear() {
@@ -29,5 +45,108 @@ void Oled::PrintText(int line_index, const char* text) {
 }
 
 void Oled::Render() {
-  render_OLed();
+  if (taskHandle == nullptr) {
+    // No display task: flush inline, as before
+    if (present_OLed()) {
+      Flush();
+    }
+    return;
+  }
+
+  // Never wait for the bus: a busy front buffer drops this frame, and the back
+  // buffer keeps its changes for the next Render()
+  if (xSemaphoreTake(frontLock, 0) != pdTRUE) {
+    CountDropped();
+    return;
+  }
+  bool presented = present_OLed();
+  if (presented && framePending) {
+    CountDropped();  // replaces a frame that never reached the screen
+  }
+  framePending = framePending || presented;
+  xSemaphoreGive(frontLock);
+
+  if (presented) {
+    xTaskNotifyGive(taskHandle);
+  }
+}
+
+void Oled::Flush() {
+  uint64_t start = time_us_64();
+  flush_OLed();
+  uint32_t elapsed = (uint32_t)(time_us_64() - start);
+
+  frameTimeUs.store(elapsed, std::memory_order_relaxed);
+  if (elapsed > maxFrameTimeUs.load(std::memory_order_relaxed)) {
+    maxFrameTimeUs.store(elapsed, std::memory_order_relaxed);
+  }
+  flushedFrames.store(flushedFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// Render() is the only writer; load + store avoids a read-modify-write the Cortex-M0+ lacks
+void Oled::CountDropped() {
+  droppedFrames.store(droppedFrames.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void Oled::StartTask() {
+  if (taskHandle == nullptr) {
+    if (frontLock == nullptr) {
+      frontLock = xSemaphoreCreateMutex();
+    }
+    if (frontLock == nullptr) {
+      printf("Failed to create Oled lock\n");
+      return;
+    }
+
+    taskRunning = true;
+    BaseType_t result = xTaskCreate(
+      DisplayTask,
+      "DisplayTask",
+      OLED_TASK_STACK_SIZE,
+      this,
+      OLED_TASK_PRIORITY,
+      &taskHandle
+    );
+
+    if (result != pdPASS) {
+      printf("Failed to create Oled task\n");
+      StopTask();
+    } else {
+      PinTaskToCore(taskHandle, CORE_IO);
+      printf("Oled task created successfully\n");
+    }
+  }
+}
+
+void Oled::StopTask() {
+  taskRunning = false;
+  if (taskHandle != nullptr) {
+    vTaskDelete(taskHandle);
+    taskHandle = nullptr;
+    printf("Oled task stopped\n");
+  }
+}
+
+void Oled::DisplayTask(void* pvParameters) {
+  Oled* oled = static_cast<Oled*>(pvParameters);
+  const TickType_t period = pdMS_TO_TICKS(OLED_FRAME_PERIOD_MS);
+  TickType_t lastFlush = xTaskGetTickCount() - period;
+
+  while (oled->taskRunning) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    // Frame pacing: presents that arrive before the slot merge into one flush
+    TickType_t elapsed = xTaskGetTickCount() - lastFlush;
+    if (elapsed < period) {
+      vTaskDelay(period - elapsed);
+    }
+
+    xSemaphoreTake(oled->frontLock, portMAX_DELAY);
+    oled->framePending = false;
+    oled->Flush();
+    xSemaphoreGive(oled->frontLock);
+    lastFlush = xTaskGetTickCount();
+  }
+
+  vTaskDelete(nullptr);
 }
@@ -1,39 +1,40 @@
 #include "imu6050.h"
+#include <stdio.h>
 
 IMU6050::IMU6050(i2c_inst_t* i2c_type, uint8_t sdata , uint8_t sclk , uint32_t i2cSpeed, uint8_t i2cAddr) {
-    _i2c = i2c_type;
+    bus = I2CBus::Get(i2c_type);
     _i2caddr = i2cAddr;
     _SDataPin = sdata;
     _SClkPin = sclk;
+    _odr = 0;
+    _fifo_overflows = 0;
     _CLKSpeed = i2cSpeed;
 }
 
 bool IMU6050::begin() {
-    // Inicializar I2C
-    i2c_init(_i2c, _CLKSpeed);
-    gpio_set_function(_SDataPin, GPIO_FUNC_I2C);
-    gpio_set_function(_SClkPin, GPIO_FUNC_I2C);
-    gpio_pull_up(_SDataPin);
-    gpio_pull_up(_SClkPin);
+    // Inicializar I2C (barramento compartilhado com os outros sensores do controlador)
+    if (!bus->begin(_SDataPin, _SClkPin, _CLKSpeed)) {
+        return false;
+    }
     
     // Aguardar um pouco para estabilização
     sleep_ms(100);
     
     // Wake up MPU6050 (sair do modo sleep)
     uint8_t wake_cmd[] = {0x6B, 0x00}; // PWR_MGMT_1 register, clear sleep bit
-    if (i2c_write_blocking(_i2c, _i2caddr, wake_cmd, 2, false) != 2) {
+    if (!bus->Transfer(_i2caddr, wake_cmd, 2, nullptr, 0, I2C_PRIORITY_LOW)) {
         return false; // Falha na comunicação I2C
     }
     
     // Configurar range do acelerômetro (±2g)
     uint8_t accel_config[] = {0x1C, 0x00}; // ACCEL_CONFIG register
-    if (i2c_write_blocking(_i2c, _i2caddr, accel_config, 2, false) != 2) {
+    if (!bus->Transfer(_i2caddr, accel_config, 2, nullptr, 0, I2C_PRIORITY_LOW)) {
         return false; // Falha na comunicação I2C
     }
     
     // Configurar range do giroscópio (±250°/s)
     uint8_t gyro_config[] = {0x1B, 0x00}; // GYRO_CONFIG register
-    if (i2c_write_blocking(_i2c, _i2caddr, gyro_config, 2, false) != 2) {
+    if (!bus->Transfer(_i2caddr, gyro_config, 2, nullptr, 0, I2C_PRIORITY_LOW)) {
         return false; // Falha na comunicação I2C
     }
     
@@ -42,13 +43,10 @@ bool IMU6050::begin() {
 }
 
 void IMU6050::read_imu6050(imu6050_data_t *data, const uint8_t *registers, uint8_t num_registers) {
-    uint8_t buffer[6]; // Buffer para 6 bytes (3 eixos x 2 bytes cada)
-    
-    // Escrever endereço do primeiro registro
-    i2c_write_blocking(_i2c, _i2caddr, (uint8_t*)registers, 1, true);
+    uint8_t buffer[6] = {0}; // Buffer para 6 bytes (3 eixos x 2 bytes cada)
     
-    // Ler dados
-    i2c_read_blocking(_i2c, _i2caddr, buffer, num_registers, false);
+    // Escrever endereço do primeiro registro e ler os dados numa só transação
+    bus->ReadRegisters(_i2caddr, registers[0], buffer, num_registers, I2C_PRIORITY_NORMAL);
     
     // Converter bytes para valores de 16 bits
     data->x = (buffer[0] << 8) | buffer[1];
@@ -57,13 +55,10 @@ void IMU6050::read_imu6050(imu6050_data_t *data, const uint8_t *registers, uint8
 }
 
 uint16_t IMU6050::read_imu6050_reg(const uint8_t *registers, uint8_t num_registers) {
-    uint8_t data[2];
-    
-    // Escrever endereço do registro
-    i2c_write_blocking(_i2c, _i2caddr, (uint8_t*)registers, 1, true);
+    uint8_t data[2] = {0};
     
-    // Ler dados
-    i2c_read_blocking(_i2c, _i2caddr, data, num_registers, false);
+    // Escrever endereço do registro e ler os dados
+    bus->ReadRegisters(_i2caddr, registers[0], data, num_registers, I2C_PRIORITY_LOW);
     
     if (num_registers == 2) {
         return (data[0] << 8) | data[1];
@@ -84,10 +79,117 @@ void IMU6050::read_gyroscope(imu6050_data_t *gyro_data) {
 
 float IMU6050::read_temperature() {
     uint8_t temp_reg = MPU_TEMP_OUT_H;
-    uint16_t raw_temp = read_imu6050_reg(&temp_reg, 2);
+    int16_t raw_temp = (int16_t)read_imu6050_reg(&temp_reg, 2);
     
-    // Converter valor bruto para graus Celsius
-    return (raw_temp / 340.0f) + 36.53f;
+    return convert_temperature(raw_temp);
+}
+
+// Quadro na ordem dos registros 0x3B..0x48, a mesma que a FIFO grava
+void IMU6050::unpack_frame(const uint8_t *bytes, imu6050_frame_t *frame) {
+    frame->accel.x = (bytes[0] << 8) | bytes[1];
+    frame->accel.y = (bytes[2] << 8) | bytes[3];
+    frame->accel.z = (bytes[4] << 8) | bytes[5];
+    frame->temperature = (bytes[6] << 8) | bytes[7];
+    frame->gyro.x = (bytes[8] << 8) | bytes[9];
+    frame->gyro.y = (bytes[10] << 8) | bytes[11];
+    frame->gyro.z = (bytes[12] << 8) | bytes[13];
+}
+
+bool IMU6050::read_frame(imu6050_frame_t *frame) {
+    uint8_t buffer[IMU6050_FRAME_BYTES] = {0};
+
+    // Registros consecutivos: uma transação em vez de três
+    if (!bus->ReadRegisters(_i2caddr, MPU_ACCEL_XOUT_H, buffer, IMU6050_FRAME_BYTES, I2C_PRIORITY_NORMAL)) {
+        return false;
+    }
+    unpack_frame(buffer, frame);
+    return true;
+}
+
+/**
+ * Liga a FIFO com accel, temperatura e gyro a odr_hz. O DLPF fica ligado (taxa interna de
+ * 1 kHz) com a maior banda abaixo de odr_hz / 2, para não haver aliasing.
+ */
+bool IMU6050::enable_fifo(uint16_t odr_hz) {
+    // Banda do DLPF por DLPF_CFG 1..6
+    static const uint16_t dlpf_bandwidth[] = {184, 94, 44, 21, 10, 5};
+
+    if (odr_hz < IMU6050_ODR_MIN_HZ || odr_hz > IMU6050_ODR_MAX_HZ || IMU6050_GYRO_RATE_HZ % odr_hz != 0) {
+        printf("IMU6050 ODR %u Hz unsupported, use a divisor of %u Hz\n", odr_hz, IMU6050_GYRO_RATE_HZ);
+        return false;
+    }
+
+    uint8_t dlpf_cfg = 6;
+    for (uint8_t i = 0; i < 6; i++) {
+        if (dlpf_bandwidth[i] <= odr_hz / 2) {
+            dlpf_cfg = i + 1;
+            break;
+        }
+    }
+
+    if (!bus->WriteRegister(_i2caddr, MPU_FIFO_EN, 0x00) ||
+        !bus->WriteRegister(_i2caddr, MPU_CONFIG, dlpf_cfg) ||
+        !bus->WriteRegister(_i2caddr, MPU_SMPLRT_DIV, IMU6050_GYRO_RATE_HZ / odr_hz - 1) ||
+        !bus->WriteRegister(_i2caddr, MPU_USER_CTRL, MPU_USER_CTRL_FIFO_EN | MPU_USER_CTRL_FIFO_RESET) ||
+        !bus->WriteRegister(_i2caddr, MPU_FIFO_EN, MPU_FIFO_EN_ALL)) {
+        return false; // Falha na comunicação I2C
+    }
+
+    _odr = odr_hz;
+    return true;
+}
+
+bool IMU6050::reset_fifo() {
+    _fifo_overflows++;
+    return bus->WriteRegister(_i2caddr, MPU_USER_CTRL, MPU_USER_CTRL_FIFO_EN | MPU_USER_CTRL_FIFO_RESET, I2C_PRIORITY_NORMAL);
+}
+
+/**
+ * Copia até max_frames quadros da FIFO, os mais antigos primeiro. Um quadro só
+ * some da FIFO quando é lido, então o que não couber fica para a próxima
+ * chamada. Quando a FIFO transborda o sensor descarta bytes soltos e perde o
+ * alinhamento dos quadros, então ela é zerada e a função retorna -1.
+ */
+int IMU6050::read_frames(imu6050_frame_t *frames, size_t max_frames) {
+    uint8_t count_bytes[2] = {0};
+    uint8_t buffer[IMU6050_FIFO_BURST_FRAMES * IMU6050_FRAME_BYTES];
+
+    if (_odr == 0) {
+        return -1;
+    }
+
+    if (!bus->ReadRegisters(_i2caddr, MPU_FIFO_COUNTH, count_bytes, 2, I2C_PRIORITY_NORMAL)) {
+        return -1;
+    }
+    uint16_t count = (count_bytes[0] << 8) | count_bytes[1];
+    if (count % IMU6050_FRAME_BYTES != 0 || count > IMU6050_FIFO_MAX_FRAMES * IMU6050_FRAME_BYTES) {
+        reset_fifo();
+        return -1;
+    }
+
+    size_t available = count / IMU6050_FRAME_BYTES;
+    if (available > max_frames) {
+        available = max_frames;
+    }
+
+    size_t read = 0;
+    while (read < available) {
+        size_t burst = available - read;
+        if (burst > IMU6050_FIFO_BURST_FRAMES) {
+            burst = IMU6050_FIFO_BURST_FRAMES;
+        }
+        if (!bus->ReadRegisters(_i2caddr, MPU_FIFO_R_W, buffer, burst * IMU6050_FRAME_BYTES, I2C_PRIORITY_NORMAL)) {
+            // Parte de um quadro pode ter saído da FIFO, recomeça alinhado
+            reset_fifo();
+            return -1;
+        }
+
+        for (size_t i = 0; i < burst; i++) {
+            unpack_frame(&buffer[i * IMU6050_FRAME_BYTES], &frames[read + i]);
+        }
+        read += burst;
+    }
+    return (int)read;
 }
 
 void IMU6050::convert_accelerometer_data(imu6050_data_t *raw_data, imu6050_calibrated_t *calibrated_data) {
@@ -101,3 +203,8 @@ void IMU6050::convert_gyroscope_data(imu6050_data_t *raw_data, imu6050_calibrate
     calibrated_data->y = raw_data->y / GYRO_RANGE_250;
     calibrated_data->z = raw_data->z / GYRO_RANGE_250;
 }
+
+float IMU6050::convert_temperature(int16_t raw_temp) {
+    // Converter valor bruto para graus Celsius
+    return (raw_temp / 340.0f) + 36.53f;
+}
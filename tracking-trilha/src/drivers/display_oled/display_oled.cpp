@@ -1,6 +1,13 @@
 #include "display_oled.h"
 
-uint8_t ssd[ssd1306_buffer_length];
+// Mesmo layout do ram_buffer de ssd1306_init_bm: o byte de controle vem antes do quadro
+uint8_t ssd_frame[ssd1306_frame_length] = {0x40};
+uint8_t *const ssd = ssd_frame + 1;
+
+// Desenho acontece em ssd (quadro de trás); present_OLed copia o que mudou para cá
+uint8_t ssd_front_frame[ssd1306_frame_length] = {0x40};
+uint8_t *const ssd_front = ssd_front_frame + 1;
+static struct dirty_area front_dirty;  // alterado no quadro da frente e ainda não enviado
 
 struct render_area frame_area = {
     start_column : 0,
@@ -32,8 +39,23 @@ void print_lines_OLed(char** text, unsigned int n_lines, int x0, int y0) {
     }
 }
 
+// Apaga só as colunas acesas de cada página, para que a renderização envie apenas o que mudou
 void clear_OLed() {
-    memset(ssd, 0, ssd1306_buffer_length);
+    for (uint page = 0; page < ssd1306_n_pages; page++) {
+        uint8_t *row = ssd + page * ssd1306_width;
+        int start = 0;
+        int end = ssd1306_width - 1;
+        while (start <= end && row[start] == 0) {
+            start++;
+        }
+        while (end >= start && row[end] == 0) {
+            end--;
+        }
+        if (start <= end) {
+            memset(row + start, 0, end - start + 1);
+            ssd1306_mark_dirty(ssd, page, page, start, end);
+        }
+    }
 }
 
 void init_OLed() {
@@ -45,6 +67,8 @@ void init_OLed() {
 
     // init do OLED SSD1306
     ssd1306_init();
+    ssd1306_track_dirty(ssd);
+    ssd1306_clear_dirty(&front_dirty);
 
     calculate_render_area_buffer_length(&frame_area);
 }
@@ -64,8 +88,25 @@ void draw_line_OLed(int x0, int y0, int x1, int y1, bool is_white) {
     ssd1306_draw_line(ssd, x0, y0, x1, y1, is_white);
 }
 
+// Só as janelas alteradas desde a última renderização vão para o barramento
 void render_OLed() {
-    render_on_display(ssd, &frame_area);
+    present_OLed();
+    flush_OLed();
+}
+
+// Fecha o quadro de trás: o que mudou nele desde a última apresentação passa para a frente.
+// Retorna false se nada mudou
+bool present_OLed() {
+    if (!ssd1306_take_dirty(ssd, &front_dirty)) {
+        return false;
+    }
+    ssd1306_copy_dirty(ssd_front, ssd, &front_dirty);
+    return true;
+}
+
+// Envia o que a frente acumulou desde o último envio
+void flush_OLed() {
+    render_dirty_area(ssd_front, &front_dirty);
 }
 
 void draw_rect_OLed(int x0, int y0, int x1, int y1, bool is_white) {
@@ -8,6 +8,14 @@
 #include "ssd1306_font.h"
 #include "ssd1306_i2c.h"
 
+// Custo fixo de uma janela no barramento: endereço, controle e 6 comandos numa transação,
+// mais o endereço e o byte de controle da transação de dados
+#define ssd1306_window_overhead (2 + 6 + 2)
+
+// Buffer acompanhado e o que mudou nele desde a última coleta
+static uint8_t *dirty_ssd = NULL;
+static struct dirty_area tracked_dirty;
+
 // Calcular quanto do buffer será destinado à área de renderização
 void calculate_render_area_buffer_length(struct render_area *area) {
     area->buffer_length = (area->end_column - area->start_column + 1) * (area->end_page - area->start_page + 1);
@@ -19,23 +27,46 @@ void ssd1306_send_command(uint8_t command) {
     i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, 2, false);
 }
 
-// Envia uma lista de comandos ao hardware
+// Envia uma lista de comandos ao hardware: com Co = 0 um único byte de controle 0x00
+// vale para todos os comandos seguintes, então a lista sai numa só transação
 void ssd1306_send_command_list(uint8_t *ssd, int number) {
-    for (int i = 0; i < number; i++) {
-        ssd1306_send_command(ssd[i]);
+    uint8_t buffer[ssd1306_command_list_max + 1];
+    buffer[0] = 0x00;
+
+    while (number > 0) {
+        int chunk = number < ssd1306_command_list_max ? number : ssd1306_command_list_max;
+        memcpy(buffer + 1, ssd, chunk);
+        i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, chunk + 1, false);
+        ssd += chunk;
+        number -= chunk;
     }
 }
 
-// Copia buffer de referência num novo buffer, a fim de adicionar o byte de controle desde o início
+// Copia o buffer para um quadro estático com o byte de controle 0x40 na frente; serve para
+// qualquer buffer, sem alocação. Buffers maiores que a tela saem em mais de uma transação
 void ssd1306_send_buffer(uint8_t ssd[], int buffer_length) {
-    uint8_t *temp_buffer = (uint8_t *)malloc(buffer_length + 1);
-
-    temp_buffer[0] = 0x40;
-    memcpy(temp_buffer + 1, ssd, buffer_length);
+    static uint8_t frame[ssd1306_frame_length];
+    frame[0] = 0x40;
+
+    while (buffer_length > 0) {
+        int chunk = buffer_length < (int)ssd1306_buffer_length ? buffer_length : (int)ssd1306_buffer_length;
+        memcpy(frame + 1, ssd, chunk);
+        i2c_write_blocking(i2c1, ssd1306_i2c_address, frame, chunk + 1, false);
+        ssd += chunk;
+        buffer_length -= chunk;
+    }
+}
 
-    i2c_write_blocking(i2c1, ssd1306_i2c_address, temp_buffer, buffer_length + 1, false);
+// Versão sem cópia, só para quadros com o byte antes de ssd reservado (ver ssd1306_frame_length).
+// No meio do quadro esse byte é pixel da página anterior: é emprestado durante a transação e
+// restaurado em seguida
+static void ssd1306_send_prefixed_buffer(uint8_t ssd[], int buffer_length) {
+    uint8_t *frame = ssd - 1;
+    uint8_t saved = frame[0];
 
-    free(temp_buffer);
+    frame[0] = 0x40;
+    i2c_write_blocking(i2c1, ssd1306_i2c_address, frame, buffer_length + 1, false);
+    frame[0] = saved;
 }
 
 // Cria a lista de comandos (com base nos endereços definidos em ssd1306_i2c.h) para a inicialização do display
@@ -85,6 +116,155 @@ void render_on_display(uint8_t *ssd, struct render_area *area) {
     ssd1306_send_buffer(ssd, area->buffer_length);
 }
 
+// Como render_on_display, para quadros com o byte de controle reservado
+static void render_prefixed_on_display(uint8_t *ssd, struct render_area *area) {
+    uint8_t commands[] = {
+        ssd1306_set_column_address, area->start_column, area->end_column,
+        ssd1306_set_page_address, area->start_page, area->end_page
+    };
+
+    ssd1306_send_command_list(commands, count_of(commands));
+    ssd1306_send_prefixed_buffer(ssd, area->buffer_length);
+}
+
+// Marca colunas de um intervalo de páginas como alteradas; outros buffers são ignorados
+void ssd1306_mark_dirty(uint8_t *ssd, int start_page, int end_page, int start_column, int end_column) {
+    if (ssd != dirty_ssd) {
+        return;
+    }
+    for (int page = start_page; page <= end_page; page++) {
+        if (start_column < tracked_dirty.start_column[page]) {
+            tracked_dirty.start_column[page] = start_column;
+        }
+        if (end_column > tracked_dirty.end_column[page]) {
+            tracked_dirty.end_column[page] = end_column;
+        }
+    }
+}
+
+void ssd1306_clear_dirty(struct dirty_area *dirty) {
+    for (uint page = 0; page < ssd1306_n_pages; page++) {
+        dirty->start_column[page] = ssd1306_width;
+        dirty->end_column[page] = 0;
+    }
+}
+
+// Passa a acompanhar as alterações de um buffer; a primeira renderização envia a tela toda
+void ssd1306_track_dirty(uint8_t *ssd) {
+    dirty_ssd = ssd;
+    ssd1306_clear_dirty(&tracked_dirty);
+    ssd1306_mark_dirty(ssd, 0, ssd1306_n_pages - 1, 0, ssd1306_width - 1);
+}
+
+// Soma ao dirty o que mudou no buffer acompanhado e recomeça o acompanhamento; false se nada mudou
+bool ssd1306_take_dirty(uint8_t *ssd, struct dirty_area *dirty) {
+    if (ssd != dirty_ssd) {
+        return false;
+    }
+    bool changed = false;
+    for (uint page = 0; page < ssd1306_n_pages; page++) {
+        if (tracked_dirty.start_column[page] > tracked_dirty.end_column[page]) {
+            continue;
+        }
+        if (tracked_dirty.start_column[page] < dirty->start_column[page]) {
+            dirty->start_column[page] = tracked_dirty.start_column[page];
+        }
+        if (tracked_dirty.end_column[page] > dirty->end_column[page]) {
+            dirty->end_column[page] = tracked_dirty.end_column[page];
+        }
+        changed = true;
+    }
+    ssd1306_clear_dirty(&tracked_dirty);
+    return changed;
+}
+
+// Copia só as faixas alteradas de um quadro para outro
+void ssd1306_copy_dirty(uint8_t *dst, const uint8_t *src, const struct dirty_area *dirty) {
+    for (uint page = 0; page < ssd1306_n_pages; page++) {
+        if (dirty->start_column[page] <= dirty->end_column[page]) {
+            int offset = page * ssd1306_width + dirty->start_column[page];
+            memcpy(dst + offset, src + offset, dirty->end_column[page] - dirty->start_column[page] + 1);
+        }
+    }
+}
+
+// Envia uma janela; colunas parciais são copiadas página a página para ficarem contíguas
+static void render_window(uint8_t *ssd, struct render_area *area) {
+    static uint8_t window_frame[ssd1306_frame_length];
+    uint8_t *window = window_frame + 1;
+
+    calculate_render_area_buffer_length(area);
+    uint8_t *first = ssd + area->start_page * ssd1306_width + area->start_column;
+    if (area->start_column == 0 && area->end_column == ssd1306_width - 1) {
+        render_prefixed_on_display(first, area);
+        return;
+    }
+
+    int width = area->end_column - area->start_column + 1;
+    for (int page = 0; page <= area->end_page - area->start_page; page++) {
+        memcpy(window + page * width, first + page * ssd1306_width, width);
+    }
+    render_prefixed_on_display(window, area);
+}
+
+// Envia as faixas de dirty e as limpa. Páginas vizinhas viram um único retângulo quando
+// as colunas a mais custam menos que os comandos de mais uma janela
+void render_dirty_area(uint8_t *ssd, struct dirty_area *dirty) {
+    struct render_area area;
+    bool open = false;
+    for (uint page = 0; page < ssd1306_n_pages; page++) {
+        uint8_t start = dirty->start_column[page];
+        uint8_t end = dirty->end_column[page];
+        dirty->start_column[page] = ssd1306_width;
+        dirty->end_column[page] = 0;
+        if (start > end) {
+            if (open) {
+                render_window(ssd, &area);
+                open = false;
+            }
+            continue;
+        }
+
+        if (open) {
+            int pages = area.end_page - area.start_page + 1;
+            uint8_t merged_start = start < area.start_column ? start : area.start_column;
+            uint8_t merged_end = end > area.end_column ? end : area.end_column;
+            int merged = (merged_end - merged_start + 1) * (pages + 1);
+            int separate = (area.end_column - area.start_column + 1) * pages + (end - start + 1) + ssd1306_window_overhead;
+            if (merged <= separate) {
+                area.start_column = merged_start;
+                area.end_column = merged_end;
+                area.end_page = page;
+                continue;
+            }
+            render_window(ssd, &area);
+        }
+
+        area.start_column = start;
+        area.end_column = end;
+        area.start_page = page;
+        area.end_page = page;
+        open = true;
+    }
+    if (open) {
+        render_window(ssd, &area);
+    }
+}
+
+// Envia só o que mudou desde a última chamada; ssd precisa reservar o byte de controle
+void render_dirty_on_display(uint8_t *ssd) {
+    if (ssd != dirty_ssd) {
+        struct render_area full = {0, ssd1306_width - 1, 0, ssd1306_n_pages - 1, 0};
+        render_window(ssd, &full);
+        return;
+    }
+
+    struct dirty_area dirty;
+    ssd1306_clear_dirty(&dirty);
+    ssd1306_take_dirty(ssd, &dirty);
+    render_dirty_area(ssd, &dirty);
+}
+
 // Determina o pixel a ser aceso (no display) de acordo com a coordenada fornecida
 void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set) {
     assert(x >= 0 && x < ssd1306_width && y >= 0 && y < ssd1306_height);
@@ -101,7 +281,10 @@ void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set) {
         byte &= ~(1 << (y % 8));
     }
 
-    ssd[byte_idx] = byte;
+    if (byte != ssd[byte_idx]) {
+        ssd[byte_idx] = byte;
+        ssd1306_mark_dirty(ssd, y / 8, y / 8, x, x);
+    }
 }
 
 // Algoritmo de Bresenham básico
@@ -157,8 +340,19 @@ void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character) {
     int idx = ssd1306_get_font(character);
     int fb_idx = y * 128 + x;
 
+    // Redesenhar o mesmo caractere não suja a página
+    int first = 8, last = -1;
     for (int i = 0; i < 8; i++) {
-        ssd[fb_idx++] = font[idx * 8 + i];
+        if (ssd[fb_idx + i] != font[idx * 8 + i]) {
+            ssd[fb_idx + i] = font[idx * 8 + i];
+            if (first > i) {
+                first = i;
+            }
+            last = i;
+        }
+    }
+    if (last >= 0) {
+        ssd1306_mark_dirty(ssd, y, y, x + first, x + last);
     }
 }
 
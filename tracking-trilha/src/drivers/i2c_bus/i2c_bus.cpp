@@ -0,0 +1,271 @@
+#include "i2c_bus.h"
+#include <stdio.h>
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "core_affinity.h"
+
+I2CBus I2CBus::buses[NUM_I2CS];
+
+I2CBus::I2CBus() {
+    _i2c = nullptr;
+    _sdaPin = 0;
+    _sclPin = 0;
+    initialized = false;
+    for (size_t i = 0; i < I2C_PRIORITY_QTT; i++) {
+        queues[i] = nullptr;
+    }
+    taskHandle = nullptr;
+    dmaTxChannel = -1;
+    dmaRxChannel = -1;
+    dmaDone = nullptr;
+    transactions = 0;
+    coalesced = 0;
+}
+
+I2CBus* I2CBus::Get(i2c_inst_t* i2c) {
+    I2CBus* bus = &buses[i2c_hw_index(i2c)];
+    bus->_i2c = i2c;
+    return bus;
+}
+
+bool I2CBus::begin(uint8_t sdaPin, uint8_t sclPin, uint32_t speed) {
+    if (initialized) {
+        if (sdaPin != _sdaPin || sclPin != _sclPin) {
+            printf("I2C%u already runs on pins %u/%u\n", i2c_hw_index(_i2c), _sdaPin, _sclPin);
+            return false;
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < I2C_PRIORITY_QTT; i++) {
+        queues[i] = xQueueCreate(I2C_BUS_QUEUE_LENGTH, sizeof(i2c_transfer_t*));
+        if (queues[i] == nullptr) {
+            printf("Failed to create I2C%u queues\n", i2c_hw_index(_i2c));
+            return false;
+        }
+    }
+
+    if (xTaskCreate(BusTask, i2c_hw_index(_i2c) ? "I2C1" : "I2C0", I2C_BUS_TASK_STACK_SIZE, this, I2C_BUS_TASK_PRIORITY, &taskHandle) != pdPASS) {
+        printf("Failed to create I2C%u task\n", i2c_hw_index(_i2c));
+        taskHandle = nullptr;
+        return false;
+    }
+    PinTaskToCore(taskHandle, CORE_IO);
+
+    i2c_init(_i2c, speed);
+    gpio_set_function(sdaPin, GPIO_FUNC_I2C);
+    gpio_set_function(sclPin, GPIO_FUNC_I2C);
+    gpio_pull_up(sdaPin);
+    gpio_pull_up(sclPin);
+
+    _sdaPin = sdaPin;
+    _sclPin = sclPin;
+    initialized = true;
+    return true;
+}
+
+/**
+ * Claims two DMA channels so long reads run as a single DMA-fed transfer:
+ * one channel feeds read commands to the controller, the other moves the
+ * received bytes out. Returns false if no channels are free.
+ */
+bool I2CBus::EnableDMA() {
+    if (dmaRxChannel >= 0) return true;
+
+    dmaTxChannel = dma_claim_unused_channel(false);
+    dmaRxChannel = dma_claim_unused_channel(false);
+    dmaDone = xSemaphoreCreateBinary();
+    if (dmaTxChannel < 0 || dmaRxChannel < 0 || dmaDone == nullptr) {
+        if (dmaTxChannel >= 0) dma_channel_unclaim(dmaTxChannel);
+        if (dmaRxChannel >= 0) dma_channel_unclaim(dmaRxChannel);
+        if (dmaDone != nullptr) vSemaphoreDelete(dmaDone);
+        dmaTxChannel = dmaRxChannel = -1;
+        dmaDone = nullptr;
+        return false;
+    }
+
+    // One shared handler serves every bus; add it once
+    bool handlerInstalled = false;
+    for (size_t i = 0; i < NUM_I2CS; i++) {
+        if (&buses[i] != this && buses[i].dmaRxChannel >= 0) {
+            handlerInstalled = true;
+        }
+    }
+    if (!handlerInstalled) {
+        irq_add_shared_handler(DMA_IRQ_1, DmaIrqHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_1, true);
+    }
+    dma_channel_set_irq1_enabled(dmaRxChannel, true);
+    return true;
+}
+
+void I2CBus::DmaIrqHandler(void) {
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    for (size_t i = 0; i < NUM_I2CS; i++) {
+        I2CBus* bus = &buses[i];
+        if (bus->dmaRxChannel >= 0 && dma_channel_get_irq1_status(bus->dmaRxChannel)) {
+            dma_channel_acknowledge_irq1(bus->dmaRxChannel);
+            xSemaphoreGiveFromISR(bus->dmaDone, &higherPriorityTaskWoken);
+        }
+    }
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+bool I2CBus::Transfer(uint8_t address, const uint8_t* tx, size_t txLength, uint8_t* rx, size_t rxLength, i2c_priority_t priority) {
+    i2c_transfer_t transfer = {address, tx, txLength, rx, rxLength, false, nullptr};
+
+    if (!initialized) {
+        return false;
+    }
+
+    // Start-up code runs alone, no need for the bus task
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        transactions++;
+        return Execute(&transfer, false);
+    }
+
+    transfer.caller = xTaskGetCurrentTaskHandle();
+    i2c_transfer_t* pending = &transfer;
+    if (xQueueSend(queues[priority], &pending, portMAX_DELAY) != pdTRUE) {
+        return false;
+    }
+    xTaskNotifyGive(taskHandle);
+    ulTaskNotifyTakeIndexed(I2C_BUS_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+    return transfer.ok;
+}
+
+bool I2CBus::ReadRegisters(uint8_t address, uint8_t reg, uint8_t* dst, size_t length, i2c_priority_t priority) {
+    return Transfer(address, &reg, 1, dst, length, priority);
+}
+
+bool I2CBus::WriteRegister(uint8_t address, uint8_t reg, uint8_t value, i2c_priority_t priority) {
+    uint8_t buf[2] = {reg, value};
+    return Transfer(address, buf, 2, nullptr, 0, priority);
+}
+
+// Highest priority first
+bool I2CBus::Dequeue(i2c_transfer_t** transfer) {
+    for (size_t i = 0; i < I2C_PRIORITY_QTT; i++) {
+        if (xQueueReceive(queues[i], transfer, 0) == pdTRUE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Head of the highest non-empty queue, left queued; *queue tells which one to receive it from
+bool I2CBus::Peek(i2c_transfer_t** transfer, size_t* queue) {
+    for (size_t i = 0; i < I2C_PRIORITY_QTT; i++) {
+        if (xQueuePeek(queues[i], transfer, 0) == pdTRUE) {
+            *queue = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs on the bus task, or inline before the scheduler starts
+bool I2CBus::Execute(i2c_transfer_t* transfer, bool holdBus) {
+    uint32_t timeout = I2C_BUS_TIMEOUT_US + (transfer->txLength + transfer->rxLength) * I2C_BUS_TIMEOUT_US_PER_BYTE;
+    bool reading = transfer->rxLength > 0;
+
+    if (transfer->txLength > 0) {
+        int written = i2c_write_timeout_us(_i2c, transfer->address, transfer->tx, transfer->txLength, reading || holdBus, timeout);
+        if (written != (int)transfer->txLength) {
+            return false;
+        }
+    }
+    if (!reading) {
+        return true;
+    }
+
+    if (dmaRxChannel >= 0 && transfer->rxLength >= I2C_BUS_DMA_MIN_BYTES && transfer->rxLength <= I2C_BUS_DMA_MAX_BYTES) {
+        return ReadDMA(transfer->rx, transfer->rxLength, holdBus);
+    }
+    return i2c_read_timeout_us(_i2c, transfer->address, transfer->rx, transfer->rxLength, holdBus, timeout) == (int)transfer->rxLength;
+}
+
+// Called right after the register address was written with a pending restart
+bool I2CBus::ReadDMA(uint8_t* dst, size_t length, bool holdBus) {
+    i2c_hw_t *hw = i2c_get_hw(_i2c);
+
+    // Every received byte needs a read command; the first one restarts, the last one stops
+    for (size_t i = 0; i < length; i++) {
+        dmaCommands[i] = I2C_IC_DATA_CMD_CMD_BITS;
+    }
+    dmaCommands[0] |= I2C_IC_DATA_CMD_RESTART_BITS;
+    if (!holdBus) {
+        dmaCommands[length - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    }
+
+    dma_channel_config rx = dma_channel_get_default_config(dmaRxChannel);
+    channel_config_set_transfer_data_size(&rx, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx, false);
+    channel_config_set_write_increment(&rx, true);
+    channel_config_set_dreq(&rx, i2c_get_dreq(_i2c, false));
+    dma_channel_configure(dmaRxChannel, &rx, dst, &hw->data_cmd, length, false);
+
+    dma_channel_config tx = dma_channel_get_default_config(dmaTxChannel);
+    channel_config_set_transfer_data_size(&tx, DMA_SIZE_16);
+    channel_config_set_read_increment(&tx, true);
+    channel_config_set_write_increment(&tx, false);
+    channel_config_set_dreq(&tx, i2c_get_dreq(_i2c, true));
+    dma_channel_configure(dmaTxChannel, &tx, &hw->data_cmd, dmaCommands, length, false);
+
+    xSemaphoreTake(dmaDone, 0); // drop a stale completion
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+    dma_start_channel_mask((1u << dmaRxChannel) | (1u << dmaTxChannel));
+
+    uint32_t timeoutUs = I2C_BUS_TIMEOUT_US + length * I2C_BUS_TIMEOUT_US_PER_BYTE;
+    bool ok;
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        ok = xSemaphoreTake(dmaDone, pdMS_TO_TICKS(timeoutUs / 1000 + 1)) == pdTRUE;
+    } else {
+        // No task to block: poll under the same timeout so a NACK cannot hang start-up
+        uint64_t start = time_us_64();
+        while (dma_channel_is_busy(dmaRxChannel) && time_us_64() - start < timeoutUs) {
+            tight_loop_contents();
+        }
+        ok = !dma_channel_is_busy(dmaRxChannel);
+    }
+
+    if (!ok) {
+        // NACK or stuck bus: stop both channels and clear the abort
+        dma_channel_abort(dmaTxChannel);
+        dma_channel_abort(dmaRxChannel);
+        (void)hw->clr_tx_abrt;
+    }
+    hw->dma_cr = 0;
+    _i2c->restart_on_next = ok && holdBus;
+    return ok;
+}
+
+void I2CBus::BusTask(void* pvParameters) {
+    I2CBus* bus = static_cast<I2CBus*>(pvParameters);
+    i2c_transfer_t* current;
+    i2c_transfer_t* next;
+    size_t queue;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (bus->Dequeue(&current)) {
+            bus->transactions++;
+
+            // Same device next in line: keep the bus and continue with a repeated start.
+            // The candidate is only peeked, so a drain queued while current runs still goes
+            // first unless current already committed the bus to the candidate.
+            while (true) {
+                bool chain = bus->Peek(&next, &queue) && next->address == current->address;
+                current->ok = bus->Execute(current, chain);
+                xTaskNotifyGiveIndexed(current->caller, I2C_BUS_NOTIFY_INDEX);
+                if (!chain || !current->ok) {
+                    break;
+                }
+
+                xQueueReceive(bus->queues[queue], &current, 0);
+                bus->coalesced++;
+            }
+        }
+    }
+}
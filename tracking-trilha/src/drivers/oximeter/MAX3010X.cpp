@@ -1,4 +1,7 @@
 #include "MAX3010X.h"
+#include "task.h"
+
+static_assert(MAX3010X_FIFO_BYTES <= I2C_BUS_DMA_MAX_BYTES, "A whole MAX3010X FIFO must fit one DMA transfer");
 
 // Status Registers
 static const uint8_t REG_INTSTAT1 =				0x00;
@@ -122,16 +125,22 @@ static const uint8_t SLOT_RED_PILOT =			0x05;
 static const uint8_t SLOT_IR_PILOT =			0x06;
 static const uint8_t SLOT_GREEN_PILOT =			0x07;
 
-MAX3010X::MAX3010X(i2c_inst_t* i2c_type, uint8_t SDApin , uint8_t SCLKpin, uint32_t i2cSpeed, uint8_t i2cAddr) {
+// Yield to other tasks while polling once the scheduler runs; spin only during start-up
+void MAX3010XBase::pollDelayMs(uint32_t ms) {
+	if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+		vTaskDelay(pdMS_TO_TICKS(ms));
+	} else {
+		busy_wait_ms(ms);
+	}
+}
+
+MAX3010XBase::MAX3010XBase(i2c_inst_t* i2c_type, uint8_t SDApin , uint8_t SCLKpin, uint32_t i2cSpeed, uint8_t i2cAddr) {
 	// Constructor
 	_i2caddr = i2cAddr;
-	_i2c = i2c_type; 
+	bus = I2CBus::Get(i2c_type);
     _SClkPin = SCLKpin;
     _SDataPin = SDApin;
     _CLKSpeed = i2cSpeed;
-    
-    // Initialize thread safety
-    i2cMutex = xSemaphoreCreateMutex();
 }
 
 /**
@@ -139,13 +148,12 @@ MAX3010X::MAX3010X(i2c_inst_t* i2c_type, uint8_t SDApin , uint8_t SCLKpin, uint3
  * Returns negative number on failure.
  * Returns sensor revision on success.
  */
-bool MAX3010X::begin() {
+bool MAX3010XBase::begin() {
 
-	i2c_init(_i2c, _CLKSpeed);
-	gpio_set_function(_SDataPin, GPIO_FUNC_I2C);
-    gpio_set_function(_SClkPin, GPIO_FUNC_I2C);
-	gpio_pull_up(_SDataPin);
-    gpio_pull_up(_SClkPin);
+	if (!bus->begin(_SDataPin, _SClkPin, _CLKSpeed))
+	{
+		return false;
+	}
 	
 	if (readPartID() != MAX3010X_EXPECTEDPARTID)
 	{
@@ -159,47 +167,47 @@ bool MAX3010X::begin() {
 
 // INterrupt configuration //
 
-uint8_t MAX3010X::getINT1(void) {
-	return readRegister(_i2caddr, REG_INTSTAT1);
+uint8_t MAX3010XBase::getINT1(void) {
+	return readRegister(_i2caddr, REG_INTSTAT1, I2C_PRIORITY_HIGH); // part of every FIFO drain
 	// return (i2c_smbus_read_byte_data(_i2c, REG_INTSTAT1));
 }
-uint8_t MAX3010X::getINT2(void) {
+uint8_t MAX3010XBase::getINT2(void) {
 	return readRegister(_i2caddr, REG_INTSTAT2);
 	// return (i2c_smbus_read_byte_data(_i2c, REG_INTSTAT2));
 }
 
-void MAX3010X::enableAFULL(void) {
+void MAX3010XBase::enableAFULL(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_A_FULL, INT_A_FULL_ENABLE);
 }
-void MAX3010X::disableAFULL(void) {
+void MAX3010XBase::disableAFULL(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_A_FULL, INT_A_FULL_DISABLE);
 }
 
-void MAX3010X::enableDATARDY(void) {
+void MAX3010XBase::enableDATARDY(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_DATA_RDY, INT_DATA_RDY_ENABLE);
 }
-void MAX3010X::disableDATARDY(void) {
+void MAX3010XBase::disableDATARDY(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_DATA_RDY, INT_DATA_RDY_DISABLE);
 }
 
-void MAX3010X::enableALCOVF(void) {
+void MAX3010XBase::enableALCOVF(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_ALC_OVF, INT_ALC_OVF_ENABLE);
 }
-void MAX3010X::disableALCOVF(void) {
+void MAX3010XBase::disableALCOVF(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_ALC_OVF, INT_ALC_OVF_DISABLE);
 }
 
-void MAX3010X::enablePROXINT(void) {
+void MAX3010XBase::enablePROXINT(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_PROX_INT, INT_PROX_INT_ENABLE);
 }
-void MAX3010X::disablePROXINT(void) {
+void MAX3010XBase::disablePROXINT(void) {
 	bitMask(REG_INTENABLE1, MASK_INT_PROX_INT, INT_PROX_INT_DISABLE);
 }
 
-void MAX3010X::enableDIETEMPRDY(void) {
+void MAX3010XBase::enableDIETEMPRDY(void) {
 	bitMask(REG_INTENABLE2, MASK_INT_DIE_TEMP_RDY, INT_DIE_TEMP_RDY_ENABLE);
 }
-void MAX3010X::disableDIETEMPRDY(void) {
+void MAX3010XBase::disableDIETEMPRDY(void) {
 	bitMask(REG_INTENABLE2, MASK_INT_DIE_TEMP_RDY, INT_DIE_TEMP_RDY_DISABLE);
 }
 
@@ -209,7 +217,7 @@ void MAX3010X::disableDIETEMPRDY(void) {
 /**
  * Pull sensor out of low power mode.
  */
-void MAX3010X::wakeUp(void) {
+void MAX3010XBase::wakeUp(void) {
 	bitMask(REG_MODECONFIG, MASK_SHUTDOWN, WAKEUP);
 }
 
@@ -218,7 +226,7 @@ void MAX3010X::wakeUp(void) {
  * During this mode the sensor will continue to respond to I2C commands
  * but will not update or take new readings, such as temperature.
  */
-void MAX3010X::shutDown(void) {
+void MAX3010XBase::shutDown(void) {
 	bitMask(REG_MODECONFIG, MASK_SHUTDOWN, SHUTDOWN);
 }
 
@@ -227,7 +235,7 @@ void MAX3010X::shutDown(void) {
  * to their power-on state through a power-on reset.
  * The reset bit is cleared back to zero after reset finishes.
  */
-void MAX3010X::softReset(void) {
+void MAX3010XBase::softReset(void) {
 	bitMask(REG_MODECONFIG, MASK_RESET, RESET);
 
 	// Poll for bit to clear, reset is then complete
@@ -238,7 +246,7 @@ void MAX3010X::softReset(void) {
 		uint8_t response = readRegister(_i2caddr, REG_MODECONFIG);
 		// uint8_t response = i2c_smbus_read_byte_data(_i2c, REG_MODECONFIG);
 		if ((response & RESET) == 0) break; // Done reset!
-		busy_wait_ms(1); // Prevent over burden the I2C bus
+		pollDelayMs(1); // Prevent over burden the I2C bus
 	}
 }
 
@@ -248,7 +256,7 @@ void MAX3010X::softReset(void) {
  * - Red+IR only
  * - Custom
  */
-void MAX3010X::setLEDMode(uint8_t mode) {
+void MAX3010XBase::setLEDMode(uint8_t mode) {
 	bitMask(REG_MODECONFIG, MASK_LEDMODE, mode);
 }
 
@@ -256,7 +264,7 @@ void MAX3010X::setLEDMode(uint8_t mode) {
  * Sets ADC Range.
  * Available ADC Range: 2048, 4096, 8192, 16384
  */
-void MAX3010X::setADCRange(uint8_t adcRange) {
+void MAX3010XBase::setADCRange(uint8_t adcRange) {
 	bitMask(REG_PARTICLECONFIG, MASK_ADCRANGE, adcRange);
 }
 
@@ -264,7 +272,7 @@ void MAX3010X::setADCRange(uint8_t adcRange) {
  * Sets Sample Rate.
  * Available Sample Rates: 50, 100, 200, 400, 800, 1000, 1600, 3200
  */
-void MAX3010X::setSampleRate(uint8_t sampleRate) {
+void MAX3010XBase::setSampleRate(uint8_t sampleRate) {
 	bitMask(REG_PARTICLECONFIG, MASK_SAMPLERATE, sampleRate);
 }
 
@@ -272,14 +280,14 @@ void MAX3010X::setSampleRate(uint8_t sampleRate) {
  * Sets Pulse Width.
  * Available Pulse Width: 69, 188, 215, 411
  */
-void MAX3010X::setPulseWidth(uint8_t pulseWidth) {
+void MAX3010XBase::setPulseWidth(uint8_t pulseWidth) {
 	bitMask(REG_PARTICLECONFIG, MASK_PULSEWIDTH, pulseWidth);
 }
 
 /**
  * Sets Red LED Pulse Amplitude.
  */
-void MAX3010X::setPulseAmplitudeRed(uint8_t amplitude) {
+void MAX3010XBase::setPulseAmplitudeRed(uint8_t amplitude) {
 	writeRegister(_i2caddr, REG_LED1_PULSEAMP, amplitude);
 	// i2c_smbus_write_byte_data(_i2c, REG_LED1_PULSEAMP, amplitude);
 }
@@ -287,17 +295,17 @@ void MAX3010X::setPulseAmplitudeRed(uint8_t amplitude) {
 /**
  * Sets IR LED Pulse Amplitude.
  */
-void MAX3010X::setPulseAmplitudeIR(uint8_t amplitude) {
+void MAX3010XBase::setPulseAmplitudeIR(uint8_t amplitude) {
 	writeRegister(_i2caddr, REG_LED2_PULSEAMP, amplitude);
 	// i2c_smbus_write_byte_data(_i2c, REG_LED2_PULSEAMP, amplitude);
 }
 
-void MAX3010X::setPulseAmplitudeGreen(uint8_t amplitude) {
+void MAX3010XBase::setPulseAmplitudeGreen(uint8_t amplitude) {
 	writeRegister(_i2caddr, REG_LED3_PULSEAMP, amplitude);
 	// i2c_smbus_write_byte_data(_i2c, REG_LED3_PULSEAMP, amplitude);
 }
 
-void MAX3010X::setPulseAmplitudeProximity(uint8_t amplitude) {
+void MAX3010XBase::setPulseAmplitudeProximity(uint8_t amplitude) {
 	writeRegister(_i2caddr, REG_LED_PROX_AMP, amplitude);
 	// i2c_smbus_write_byte_data(_i2c, REG_LED_PROX_AMP, amplitude);
 }
@@ -306,7 +314,7 @@ void MAX3010X::setPulseAmplitudeProximity(uint8_t amplitude) {
  * Set the IR ADC count that will trigger the beginning of particle-sensing mode.
  * The threshMSB signifies only the 8 most significant-bits of the ADC count.
  */
-void MAX3010X::setProximityThreshold(uint8_t threshMSB) {
+void MAX3010XBase::setProximityThreshold(uint8_t threshMSB) {
 	writeRegister(_i2caddr, REG_PROXINTTHRESH, threshMSB);
 	// i2c_smbus_write_byte_data(_i2c, REG_PROXINTTHRESH, threshMSB);
 }
@@ -317,7 +325,7 @@ void MAX3010X::setProximityThreshold(uint8_t threshMSB) {
  * Assigning a SLOT_RED_LED will pulse LED
  * Assigning a SLOT_RED_PILOT will ??
  */
-void MAX3010X::enableSlot(uint8_t slotNumber, uint8_t device) {
+void MAX3010XBase::enableSlot(uint8_t slotNumber, uint8_t device) {
 	uint8_t originalContents;
 	switch (slotNumber) {
 		case (1):
@@ -341,7 +349,7 @@ void MAX3010X::enableSlot(uint8_t slotNumber, uint8_t device) {
 /**
  * Clears all slot assignments.
  */
-void MAX3010X::disableSlots(void) {
+void MAX3010XBase::disableSlots(void) {
 	writeRegister(_i2caddr, REG_MULTILEDCONFIG1, 0);
 	writeRegister(_i2caddr, REG_MULTILEDCONFIG2, 0);
 	// i2c_smbus_write_byte_data(_i2c, REG_MULTILEDCONFIG1, 0);
@@ -354,7 +362,7 @@ void MAX3010X::disableSlots(void) {
 /**
  * Sets sample average.
  */
-void MAX3010X::setFIFOAverage(uint8_t numberOfSamples) {
+void MAX3010XBase::setFIFOAverage(uint8_t numberOfSamples) {
 	bitMask(REG_FIFOCONFIG, MASK_SAMPLEAVG, numberOfSamples);
 }
 
@@ -362,7 +370,7 @@ void MAX3010X::setFIFOAverage(uint8_t numberOfSamples) {
  * Resets all points to start in a known state.
  * Recommended to clear FIFO before beginning a read.
  */
-void MAX3010X::clearFIFO(void) {
+void MAX3010XBase::clearFIFO(void) {
 	writeRegister(_i2caddr, REG_FIFOWRITEPTR, 0);
 	writeRegister(_i2caddr, REG_FIFOOVERFLOW, 0);
 	writeRegister(_i2caddr, REG_FIFOREADPTR, 0);
@@ -374,14 +382,14 @@ void MAX3010X::clearFIFO(void) {
 /**
  * Enable roll over if FIFO over flows.
  */
-void MAX3010X::enableFIFORollover(void) {
+void MAX3010XBase::enableFIFORollover(void) {
 	bitMask(REG_FIFOCONFIG, MASK_ROLLOVER, ROLLOVER_ENABLE);
 }
 
 /**
  * Disable roll over if FIFO over flows.
  */
-void MAX3010X::disableFIFORollover(void) {
+void MAX3010XBase::disableFIFORollover(void) {
         bitMask(REG_FIFOCONFIG, MASK_ROLLOVER, ROLLOVER_DISABLE);
 }
 
@@ -389,23 +397,23 @@ void MAX3010X::disableFIFORollover(void) {
  * Sets number of samples to trigger the almost full interrupt.
  * Power on deafult is 32 samples.
  */
-void MAX3010X::setFIFOAlmostFull(uint8_t numberOfSamples) {
+void MAX3010XBase::setFIFOAlmostFull(uint8_t numberOfSamples) {
 	bitMask(REG_FIFOCONFIG, MASK_A_FULL, numberOfSamples);
 }
 
 /**
  * Read the FIFO Write Pointer.
  */
-uint8_t MAX3010X::getWritePointer(void) {
-	return (readRegister(_i2caddr, REG_FIFOWRITEPTR));
+uint8_t MAX3010XBase::getWritePointer(void) {
+	return (readRegister(_i2caddr, REG_FIFOWRITEPTR, I2C_PRIORITY_HIGH));
 	// return (i2c_smbus_read_byte_data(_i2c, REG_FIFOWRITEPTR));
 }
 
 /**
  * Read the FIFO Read Pointer.
  */
-uint8_t MAX3010X::getReadPointer(void) {
-	return (readRegister(_i2caddr, REG_FIFOREADPTR));
+uint8_t MAX3010XBase::getReadPointer(void) {
+	return (readRegister(_i2caddr, REG_FIFOREADPTR, I2C_PRIORITY_HIGH));
 	// return (i2c_smbus_read_byte_data(_i2c, REG_FIFOREADPTR));
 }
 
@@ -413,7 +421,7 @@ uint8_t MAX3010X::getReadPointer(void) {
  * Die Temperature.
  * Returns temperature in C.
  */
-float MAX3010X::readTemperature() {
+float MAX3010XBase::readTemperature() {
 	// DIE_TEMP_RDY interrupt must be enabled.
 	
 	// Step 1: Config die temperature register to take 1 temperature sample.
@@ -428,14 +436,14 @@ float MAX3010X::readTemperature() {
 		uint8_t response = readRegister(_i2caddr, REG_INTSTAT2);
 		// uint8_t response = i2c_smbus_read_byte_data(_i2c, REG_INTSTAT2);
 		if ((response & INT_DIE_TEMP_RDY_ENABLE) > 0) break;
-		busy_wait_ms(1);
+		pollDelayMs(1);
 	}
 	
-	// Step 2: Read die temperature register (integer)
-	int8_t tempInt = readRegister(_i2caddr, REG_DIETEMPINT);
-	uint8_t tempFrac = readRegister(_i2caddr, REG_DIETEMPFRAC);
-	// int8_t tempInt = i2c_smbus_read_byte_data(_i2c, REG_DIETEMPINT);
-	// uint8_t tempFrac = i2c_smbus_read_byte_data(_i2c, REG_DIETEMPFRAC); // causes clearing of the DIE_TEMP_RDY interrupt
+	// Step 2: Read die temperature registers (integer and fraction are adjacent, one transfer)
+	uint8_t temp[2] = {0, 0};
+	bus->ReadRegisters(_i2caddr, REG_DIETEMPINT, temp, 2, I2C_PRIORITY_LOW);
+	int8_t tempInt = (int8_t)temp[0];
+	uint8_t tempFrac = temp[1]; // reading it clears the DIE_TEMP_RDY interrupt
 
 	// Step 3: Calculate temperature.
 	return (float)tempInt + ((float)tempFrac * 0.0625);
@@ -444,7 +452,7 @@ float MAX3010X::readTemperature() {
 /**
  * Returns die temperature in F.
  */
-float MAX3010X::readTemperatureF() {
+float MAX3010XBase::readTemperatureF() {
 	float temp = readTemperature();
 
 	if (temp != -999.0) temp = temp * 1.8 + 32.0;
@@ -455,7 +463,7 @@ float MAX3010X::readTemperatureF() {
 /**
  * Sets the PROX_INT_THRESHold.
  */
-void MAX3010X::setPROXINTTHRESH(uint8_t val) {
+void MAX3010XBase::setPROXINTTHRESH(uint8_t val) {
 	writeRegister(_i2caddr, REG_PROXINTTHRESH, val);
 	// i2c_smbus_write_byte_data(_i2c, REG_PROXINTTHRESH, val);
 }
@@ -463,36 +471,53 @@ void MAX3010X::setPROXINTTHRESH(uint8_t val) {
 
 // Device ID and Revision //
 
-uint8_t MAX3010X::readPartID() {
+uint8_t MAX3010XBase::readPartID() {
 	return readRegister(_i2caddr, REG_PARTID);
 	// return i2c_smbus_read_byte_data(_i2c, REG_PARTID);
 }
 
-void MAX3010X::readRevisionID() {
+void MAX3010XBase::readRevisionID() {
 	revisionID = readRegister(_i2caddr, REG_REVISIONID);
 	// revisionID = i2c_smbus_read_byte_data(_i2c, REG_REVISIONID);
 }
 
-uint8_t MAX3010X::getRevisionID() {
+uint8_t MAX3010XBase::getRevisionID() {
 	return revisionID;
 }
 
 
+// Register values for an averaging count and an ADC rate, as accepted by setup()
+static uint8_t sampleAverageBits(uint8_t sampleAverage) {
+	if (sampleAverage == 1) return SAMPLEAVG_1;
+	else if (sampleAverage == 2) return SAMPLEAVG_2;
+	else if (sampleAverage == 4) return SAMPLEAVG_4;
+	else if (sampleAverage == 8) return SAMPLEAVG_8;
+	else if (sampleAverage == 16) return SAMPLEAVG_16;
+	else if (sampleAverage == 32) return SAMPLEAVG_32;
+	else return SAMPLEAVG_4;
+}
+
+static uint8_t sampleRateBits(int sampleRate) {
+	if (sampleRate < 100) return SAMPLERATE_50;
+	else if (sampleRate < 200) return SAMPLERATE_100;
+	else if (sampleRate < 400) return SAMPLERATE_200;
+	else if (sampleRate < 800) return SAMPLERATE_400;
+	else if (sampleRate < 1000) return SAMPLERATE_800;
+	else if (sampleRate < 1600) return SAMPLERATE_1000;
+	else if (sampleRate < 3200) return SAMPLERATE_1600;
+	else if (sampleRate == 3200) return SAMPLERATE_3200;
+	else return SAMPLERATE_50;
+}
+
 // Setup the Sensor
-void MAX3010X::setup(uint8_t powerLevel, uint8_t sampleAverage, uint8_t ledMode, int sampleRate, int pulseWidth, int adcRange) {
+void MAX3010XBase::setup(uint8_t powerLevel, uint8_t sampleAverage, uint8_t ledMode, int sampleRate, int pulseWidth, int adcRange) {
 	// Reset all configuration, threshold, and data registers to POR values
 	softReset();
 
 	// FIFO Configuration //
 	
 	// The chip will average multiple samples of same type together if you wish
-	if (sampleAverage == 1) setFIFOAverage(SAMPLEAVG_1);
-	else if (sampleAverage == 2) setFIFOAverage(SAMPLEAVG_2);
-	else if (sampleAverage == 4) setFIFOAverage(SAMPLEAVG_4);
-	else if (sampleAverage == 8) setFIFOAverage(SAMPLEAVG_8);
-	else if (sampleAverage == 16) setFIFOAverage(SAMPLEAVG_16);
-	else if (sampleAverage == 32) setFIFOAverage(SAMPLEAVG_32);
-	else setFIFOAverage(SAMPLEAVG_4);
+	setFIFOAverage(sampleAverageBits(sampleAverage));
 
 	// Allow FIFO to wrap/roll over
 	enableFIFORollover();
@@ -510,15 +535,7 @@ void MAX3010X::setup(uint8_t powerLevel, uint8_t sampleAverage, uint8_t ledMode,
 	else if (adcRange == 16384) setADCRange(ADCRANGE_16384);
 	else setADCRange(ADCRANGE_2048);
 	
-	if (sampleRate < 100) setSampleRate(SAMPLERATE_50);
-	else if (sampleRate < 200) setSampleRate(SAMPLERATE_100);
-	else if (sampleRate < 400) setSampleRate(SAMPLERATE_200);
-	else if (sampleRate < 800) setSampleRate(SAMPLERATE_400);
-	else if (sampleRate < 1000) setSampleRate(SAMPLERATE_800);
-	else if (sampleRate < 1600) setSampleRate(SAMPLERATE_1000);
-	else if (sampleRate < 3200) setSampleRate(SAMPLERATE_1600);
-	else if (sampleRate == 3200) setSampleRate(SAMPLERATE_3200);
-	else setSampleRate(SAMPLERATE_50);
+	setSampleRate(sampleRateBits(sampleRate));
 
 	if (pulseWidth < 118) setPulseWidth(PULSEWIDTH_69);	  // 15 bit resolution
 	else if (pulseWidth < 215) setPulseWidth(PULSEWIDTH_118); // 16 bit resolution
@@ -543,225 +560,81 @@ void MAX3010X::setup(uint8_t powerLevel, uint8_t sampleAverage, uint8_t ledMode,
 }
 
 
-// Data Collection //
-
-/**
- * Returns the number of samples available.
- */
-uint8_t MAX3010X::available(void)
-{
-	int8_t numberOfSamples = sense.head - sense.tail;
-	if (numberOfSamples < 0) numberOfSamples += STORAGE_SIZE;
-	return (numberOfSamples);
-}
+// Keeps the FIFO, slots and interrupts as they are; only the acquisition timing and LED current change
+void MAX3010XBase::setAcquisition(uint8_t powerLevel, uint8_t sampleAverage, int sampleRate) {
+	setFIFOAverage(sampleAverageBits(sampleAverage));
+	setSampleRate(sampleRateBits(sampleRate));
 
-/**
- * Report the most recent Red value.
- */
-uint32_t MAX3010X::getRed(void)
-{
-	if(safeCheck(250))
-		return (sense.red[sense.head]);
-	else
-		return(0);
+	setPulseAmplitudeRed(powerLevel);
+	setPulseAmplitudeIR(powerLevel);
+	setPulseAmplitudeGreen(powerLevel);
 }
 
-/**
- * Report the most recent IR value.
- */
-uint32_t MAX3010X::getIR(void)
-{
-	if(safeCheck(250))
-		return (sense.IR[sense.head]);
-	else
-		return(0);
-}
 
-/**
- * Report the most recent Green value.
-*/
-uint32_t MAX3010X::getGreen(void)
-{
-    if(safeCheck(250))
-        return (sense.green[sense.head]);
-    else
-        return(0);
-}
+// Data Collection //
 
 /**
- * Report the next Red value in FIFO.
+ * Lets the bus read the whole FIFO in a single DMA-fed I2C transfer.
+ * Returns false if no DMA channels are free.
  */
-uint32_t MAX3010X::getFIFORed(void)
-{
-	return (sense.red[sense.tail]);
+bool MAX3010XBase::enableBurstDMA(void) {
+	return bus->EnableDMA();
 }
 
 /**
- * Report the next IR value in FIFO.
+ * Reads every pending FIFO sample into dst as raw 3-byte words.
+ * The write pointer, overflow counter and read pointer are adjacent
+ * registers and come in one transfer, the samples in a second one. Both
+ * are queued at high priority. The caller unpacks the bytes with unpackFIFO().
  */
-uint32_t MAX3010X::getFIFOIR(void)
-{
-	return (sense.IR[sense.tail]);
-}
+uint16_t MAX3010XBase::readFIFOBurst(uint8_t *dst, size_t capacity) {
+	uint8_t pointers[3]; // FIFO_WR_PTR, OVF_COUNTER, FIFO_RD_PTR
+	if (!bus->ReadRegisters(_i2caddr, REG_FIFOWRITEPTR, pointers, sizeof(pointers), I2C_PRIORITY_HIGH)) return 0;
+	uint8_t writePointer = pointers[0];
+	uint8_t overflow = pointers[1];
+	uint8_t readPointer = pointers[2];
+	// Equal pointers mean empty, unless samples were lost: then the FIFO is full
+	if (readPointer == writePointer && overflow == 0) return 0;
 
-/**
- * Report the next Green value in FIFO
- */
-uint32_t MAX3010X::getFIFOGreen(void)
-{
-	return (sense.green[sense.tail]);
-}
+	int numberOfSamples = writePointer - readPointer;
+	if (numberOfSamples <= 0) numberOfSamples += MAX3010X_FIFO_DEPTH;
 
-/**
- * Advance the tail.
- */
-void MAX3010X::nextSample(void)
-{
-	if(available()) {
-		sense.tail++;
-		sense.tail %= STORAGE_SIZE;
-	}
-}
+	size_t sampleBytes = activeLEDs * 3;
+	if (numberOfSamples * sampleBytes > capacity) numberOfSamples = capacity / sampleBytes;
+	size_t length = numberOfSamples * sampleBytes;
+	if (length == 0) return 0;
 
-uint16_t MAX3010X::check(void) {
-	uint8_t readPointer = getReadPointer();
-	uint8_t writePointer = getWritePointer();
-
-	int numberOfSamples = 0;
-
-	// Do we have new data?
-	if (readPointer != writePointer) {
-		// Calculate the number of readings we need to get from sensor
-		numberOfSamples = writePointer - readPointer;
-		//std::cout << "There are " << (int)numberOfSamples << " available samples." << std::endl;
-		if (numberOfSamples < 0) numberOfSamples += 32;
-
-		// We know have the number of readings, now calculate bytes to read.
-		// For this example we are just doing Red and IR (3 bytes each)
-		int bytesLeftToRead = numberOfSamples * activeLEDs * 3;
-
-		// Protect FIFO reading with mutex
-		if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE) {
-			// //Get ready to read a burst of data from the FIFO register
-			i2c_write_blocking(_i2c, _i2caddr, &REG_FIFODATA, 1, true);
-			// _i2cPort->beginTransmission(MAX30105_ADDRESS);
-			// _i2cPort->write(MAX30105_FIFODATA);
-			// _i2cPort->endTransmission();
-
-			// We may need to read as many as 288 bytes so we read in blocks no larger than I2C_BUFFER_LENGTH
-			//I2C_BUFFER_LENGTH changes based on the platform. 64 bytes for SAMD21, 32 bytes for Uno.
-			//Wire.requestFrom() is limited to BUFFER_LENGTH which is 32 on the Uno
-			while (bytesLeftToRead > 0) {
-				int toGet = bytesLeftToRead;
-				if (toGet > I2C_BUFFER_LENGTH) {
-					//If toGet is 32 this is bad because we read 6 bytes (Red+IR * 3 = 6) at a time
-					//32 % 6 = 2 left over. We don't want to request 32 bytes, we want to request 30.
-					//32 % 9 (Red+IR+GREEN) = 5 left over. We want to request 27.
-
-					// Trim toGet to be a multiple of the samples we need to read.
-					toGet = I2C_BUFFER_LENGTH - (I2C_BUFFER_LENGTH % (activeLEDs * 3));
-				}
-
-				bytesLeftToRead -= toGet;
-
-				// Request toGet number of bytes from sensor
-				int index = 0;
-				// i2c_write_blocking(_i2c, _i2caddr, &REG_FIFODATA, 1, true);
-				i2c_read_blocking(_i2c, _i2caddr, readMany, toGet, false);
-
-				while (toGet > 0) {
-					sense.head++; // Advance the head of the storage struct
-					sense.head %= STORAGE_SIZE;
-
-					uint8_t temp[sizeof(uint32_t)]; // Array of 4 bytes that we will convert into long
-					uint32_t tempLong;
-
-					// Burst read three bytes - RED
-					temp[3] = 0;
-					temp[2] = readMany[index++];
-					temp[1] = readMany[index++];
-					temp[0] = readMany[index++];
-
-					// Convert array to long
-					std::memcpy(&tempLong, temp, sizeof(tempLong));
-					
-					// Zero out all but 18 bits
-					tempLong &= 0x3FFFF;
-					
-					// Store this reading into the sense array
-					sense.red[sense.head] = tempLong;
-
-					if (activeLEDs > 1) 
-					{
-						// Burst read three more bytes - IR
-						temp[3] = 0;
-						temp[2] = readMany[index++];
-						temp[1] = readMany[index++];
-						temp[0] = readMany[index++];
-
-						// Convert array to long
-						std::memcpy(&tempLong, temp, sizeof(tempLong));
-						
-						// Zero out all 18 bits
-						tempLong &= 0x3FFFF;
-
-						sense.IR[sense.head] = tempLong;
-					}
-
-					if (activeLEDs > 2) 
-					{
-						// Burst read three more bytes - IR
-						temp[3] = 0;
-						temp[2] = readMany[index++];
-						temp[1] = readMany[index++];
-						temp[0] = readMany[index++];
-
-						// Convert array to long
-						std::memcpy(&tempLong, temp, sizeof(tempLong));
-						
-						// Zero out all 18 bits
-						tempLong &= 0x3FFFF;
-
-						sense.green[sense.head] = tempLong;
-					}
-					
-
-					toGet -= activeLEDs * 3; 
-				}
-			}
-			xSemaphoreGive(i2cMutex);
-		}
-	}
-	return (numberOfSamples);
+	bool ok = bus->ReadRegisters(_i2caddr, REG_FIFODATA, dst, length, I2C_PRIORITY_HIGH);
+	return ok ? numberOfSamples : 0;
 }
 
 /**
- * Check for new data but give up after a certain amount of time.
- * Returns true if new data was found.
- * Returns false if new data was not found.
+ * Unpacks raw FIFO words (3 bytes, MSB first, 18 significant bits) into
+ * per-LED arrays. Channels not present in activeLEDs or passed as nullptr
+ * are skipped.
  */
-bool MAX3010X::safeCheck(uint8_t maxTimeToCheck) {
-	uint32_t markTime = to_ms_since_boot(get_absolute_time());
-
-	while(1) {
-		uint32_t endTime = to_ms_since_boot(get_absolute_time());
-		if (endTime - markTime > maxTimeToCheck) {
-			return false;
+void MAX3010XBase::unpackFIFO(const uint8_t *src, uint16_t samples, uint8_t activeLEDs, uint32_t *red, uint32_t *ir, uint32_t *green) {
+	for (uint16_t i = 0; i < samples; i++) {
+		uint32_t value = ((uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2]) & 0x3FFFF;
+		if (red) red[i] = value;
+		src += 3;
+		if (activeLEDs > 1) {
+			value = ((uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2]) & 0x3FFFF;
+			if (ir) ir[i] = value;
+			src += 3;
 		}
-
-		if (check() == true) {
-			// We found new data!
-			return true;
+		if (activeLEDs > 2) {
+			value = ((uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2]) & 0x3FFFF;
+			if (green) green[i] = value;
+			src += 3;
 		}
-
-		busy_wait_ms(1);
 	}
 }
 
 /**
  * Set certain thing in register.
  */
-void MAX3010X::bitMask(uint8_t reg, uint8_t mask, uint8_t thing) {
+void MAX3010XBase::bitMask(uint8_t reg, uint8_t mask, uint8_t thing) {
 	// Read register
 	uint8_t originalContents = readRegister(_i2caddr, reg);
 	// uint8_t originalContents = i2c_smbus_read_byte_data(_i2c, reg);
@@ -774,24 +647,12 @@ void MAX3010X::bitMask(uint8_t reg, uint8_t mask, uint8_t thing) {
 	// i2c_smbus_write_byte_data(_i2c, reg, originalContents | thing);
 }
 
-uint8_t MAX3010X::readRegister(uint8_t address, uint8_t reg) {
+uint8_t MAX3010XBase::readRegister(uint8_t address, uint8_t reg, i2c_priority_t priority) {
 	uint8_t res = 0;
-	
-	if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE) {
-		i2c_write_blocking(_i2c, address, &reg, 1, true);
-		i2c_read_blocking(_i2c, address, &res, 1, false);
-		xSemaphoreGive(i2cMutex);
-	}
-
+	bus->ReadRegisters(address, reg, &res, 1, priority);
 	return res;
 }
 
-void MAX3010X::writeRegister(uint8_t address, uint8_t reg, uint8_t val) {
-	if (xSemaphoreTake(i2cMutex, portMAX_DELAY) == pdTRUE) {
-		uint8_t buf[2];
-		buf[0] = reg;
-		buf[1] = val;
-		i2c_write_blocking(_i2c, address, buf, 2, true);
-		xSemaphoreGive(i2cMutex);
-	}
-}
\ No newline at end of file
+void MAX3010XBase::writeRegister(uint8_t address, uint8_t reg, uint8_t val, i2c_priority_t priority) {
+	bus->WriteRegister(address, reg, val, priority);
+}
@@ -261,6 +261,162 @@ void rf_signal_periodicity(float *pn_x, int32_t n_size, int32_t *p_last_periodic
   *p_last_periodicity=n_lag;
 }
 
+void rf_initialize_periodicity_search_table(const float *pn_aut, int32_t *p_last_periodicity, int32_t n_max_distance, float min_aut_ratio, float aut_lag0)
+/**
+* \brief        Search the range of true signal periodicity
+* \par          Details
+*               Table-driven twin of rf_initialize_periodicity_search(): pn_aut[n_lag] holds the
+*               autocorrelation at n_lag, e.g. as maintained by the streaming engine.
+*               Determine the range of current heart rate by locating neighborhood of 
+*               the _first_ peak of the autocorrelation function. If at all lags until  
+*               n_max_distance the autocorrelation is less than min_aut_ratio fraction 
+*               of the autocorrelation at lag=0, then the input signal is insufficiently 
+*               periodic and probably indicates motion artifacts.
+*               Robert Fraczkiewicz, 04/25/2020
+* \retval       Average distance between peaks
+*/
+{
+  int32_t n_lag;
+  float aut,aut_right;
+  // At this point, *p_last_periodicity = LOWEST_PERIOD. Start walking to the right,
+  // two steps at a time, until lag ratio fulfills quality criteria or HIGHEST_PERIOD
+  // is reached.
+  n_lag=*p_last_periodicity;
+  aut_right=aut=pn_aut[n_lag];
+  // Check sanity
+  if(aut/aut_lag0 >= min_aut_ratio) {
+    // Either quality criterion, min_aut_ratio, is too low, or heart rate is too high.
+    // Are we on autocorrelation's downward slope? If yes, continue to a local minimum.
+    // If not, continue to the next block.
+    do {
+      aut=aut_right;
+      n_lag+=2;
+      aut_right=pn_aut[n_lag];
+    } while(aut_right/aut_lag0 >= min_aut_ratio && aut_right<aut && n_lag<=n_max_distance);
+    if(n_lag>n_max_distance) {
+      // This should never happen, but if does return failure
+      *p_last_periodicity=0;
+      return;
+    }
+    aut=aut_right;
+  }
+  // Walk to the right.
+  do {
+    aut=aut_right;
+    n_lag+=2;
+    aut_right=pn_aut[n_lag];
+  } while(aut_right/aut_lag0 < min_aut_ratio && n_lag<=n_max_distance);
+  if(n_lag>n_max_distance) {
+    // This should never happen, but if does return failure
+    *p_last_periodicity=0;
+  } else
+    *p_last_periodicity=n_lag;
+}
+
+void rf_signal_periodicity_table(const float *pn_aut, int32_t *p_last_periodicity, int32_t n_min_distance, int32_t n_max_distance, float min_aut_ratio, float aut_lag0, float *ratio)
+/**
+* \brief        Signal periodicity
+* \par          Details
+*               Table-driven twin of rf_signal_periodicity(): pn_aut[n_lag] holds the
+*               autocorrelation at n_lag.
+*               Finds periodicity of the IR signal which can be used to calculate heart rate.
+*               Makes use of the autocorrelation function. If peak autocorrelation is less
+*               than min_aut_ratio fraction of the autocorrelation at lag=0, then the input 
+*               signal is insufficiently periodic and probably indicates motion artifacts.
+*               Robert Fraczkiewicz, 01/07/2018
+* \retval       Average distance between peaks
+*/
+{
+  int32_t n_lag;
+  float aut,aut_left,aut_right,aut_save;
+  bool left_limit_reached=false;
+  // Start from the last periodicity computing the corresponding autocorrelation
+  n_lag=*p_last_periodicity;
+  aut_save=aut=pn_aut[n_lag];
+  // Is autocorrelation one lag to the left greater?
+  aut_left=aut;
+  do {
+    aut=aut_left;
+    n_lag--;
+    aut_left=pn_aut[n_lag];
+  } while(aut_left>aut && n_lag>=n_min_distance);
+  // Restore lag of the highest aut
+  if(n_lag<n_min_distance) {
+    left_limit_reached=true;
+    n_lag=*p_last_periodicity;
+    aut=aut_save;
+  } else n_lag++;
+  if(n_lag==*p_last_periodicity) {
+    // Trip to the left made no progress. Walk to the right.
+    aut_right=aut;
+    do {
+      aut=aut_right;
+      n_lag++;
+      aut_right=pn_aut[n_lag];
+    } while(aut_right>aut && n_lag<=n_max_distance);
+    // Restore lag of the highest aut
+    if(n_lag>n_max_distance) n_lag=0; // Indicates failure
+    else n_lag--;
+    if(n_lag==*p_last_periodicity && left_limit_reached) n_lag=0; // Indicates failure
+  }
+  *ratio=aut/aut_lag0;
+  if(*ratio < min_aut_ratio) n_lag=0; // Indicates failure
+  *p_last_periodicity=n_lag;
+}
+
+void rf_finish_from_table(const rf_params_t *pp, const float *pn_aut, float f_ir_mean, float f_red_mean, float f_ir_sumsq, float f_red_sumsq,
+                          float f_correl, int32_t *pn_last_peak_interval, float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate,
+                          int8_t *pch_hr_valid, float *ratio)
+/**
+* \brief        Heart rate and SpO2 from window statistics
+* \par          Details
+*               Tail of rf_heart_rate_and_oxygen_saturation() for callers that already have the
+*               detrended statistics of a window of pp->n_buffer_size samples: the IR autocorrelation
+*               table, the mean and mean square of both signals and their Pearson correlation.
+*
+* \param[in]    *pp                      - Configuration of the window
+* \param[in]    *pn_aut                  - IR autocorrelation, lag 0 and pp->n_aut_first_lag .. pp->n_aut_table_size-1
+* \param[in,out] *pn_last_peak_interval - Periodicity carried between calls, pp->n_lowest_period initially
+*
+* \retval       None
+*/
+{
+  float f_y_ac, f_x_ac, xy_ratio;
+
+  // Find signal periodicity
+  if(f_correl>=min_pearson_correlation) {
+    if(pp->n_lowest_period==*pn_last_peak_interval)
+      rf_initialize_periodicity_search_table(pn_aut, pn_last_peak_interval, pp->n_highest_period, min_autocorrelation_ratio, f_ir_sumsq);
+    if(*pn_last_peak_interval!=0)
+      rf_signal_periodicity_table(pn_aut, pn_last_peak_interval, pp->n_lowest_period, pp->n_highest_period, min_autocorrelation_ratio, f_ir_sumsq, ratio);
+  } else *pn_last_peak_interval=0;
+
+  // Calculate heart rate if periodicity detector was successful. Otherwise, reset peak interval to its initial value and report error.
+  if(*pn_last_peak_interval!=0) {
+    *pn_heart_rate = (int32_t)(pp->n_fs60/(*pn_last_peak_interval));
+    *pch_hr_valid  = 1;
+  } else {
+    *pn_last_peak_interval=pp->n_lowest_period;
+    *pn_heart_rate = -999; // unable to calculate because signal looks aperiodic
+    *pch_hr_valid  = 0;
+    *pn_spo2 =  -999 ; // do not use SPO2 from this corrupt signal
+    *pch_spo2_valid  = 0;
+    return;
+  }
+
+  // Calculate SpO2 from the RMS of both AC signals
+  f_x_ac = sqrt(f_ir_sumsq);
+  f_y_ac = sqrt(f_red_sumsq);
+  xy_ratio= (f_y_ac*f_ir_mean)/(f_x_ac*f_red_mean);
+  if(xy_ratio>0.02 && xy_ratio<1.84) { // Check boundaries of applicability
+    *pn_spo2 = (-45.060*xy_ratio + 30.354)*xy_ratio + 94.845;
+    *pch_spo2_valid = 1;
+  } else {
+    *pn_spo2 =  -999 ; // do not use SPO2 since signal an_ratio is out of range
+    *pch_spo2_valid  = 0;
+  }
+}
+
 float rf_rms(float *pn_x, int32_t n_size, float *sumsq) 
 /**
 * \brief        Root-mean-square variation 
@@ -0,0 +1,297 @@
+/*
+ * Fixed-point build of rf_heart_rate_and_oxygen_saturation().
+ *
+ * Cortex-M0+ has no FPU, so every float operation of the reference version is
+ * a library call. This variant keeps the same pipeline (DC removal, linear
+ * detrend, RMS, Pearson correlation, autocorrelation periodicity search and
+ * SpO2 curve) on integers:
+ *   - residuals are Q4 (1/16 of an ADC count) after DC removal and detrend,
+ *   - each channel is then shifted down just enough that any sum of n products
+ *     of residuals fits in 32 bits, so the autocorrelation loops are plain
+ *     32-bit multiply-accumulates,
+ *   - ratios are Q15 and compared by cross-multiplication, the SpO2 curve is Q16.
+ * Only the final outputs are converted to float to keep the reference interface.
+ */
+#include "algorithm_by_RF.h"
+
+#define RF_Q15_ONE 32768
+#define RF_Q16_ONE 65536
+
+// Reference thresholds and SpO2 curve coefficients (see rf_heart_rate_and_oxygen_saturation)
+static const int32_t n_min_aut_ratio_q15 = RF_Q15_ONE/2;        // min_autocorrelation_ratio = 0.5
+static const int32_t n_min_pearson_q15 = 26214;                  // min_pearson_correlation = 0.8
+static const int64_t n_spo2_a_q16 = -2953052;                    // -45.060
+static const int64_t n_spo2_b_q16 = 1989279;                     // 30.354
+static const int64_t n_spo2_c_q16 = 6215762;                     // 94.845
+static const int64_t n_ratio_min_q16 = 1311;                     // 0.02
+static const int64_t n_ratio_max_q16 = 120586;                   // 1.84
+
+static uint32_t rf_isqrt64(uint64_t un_x)
+/**
+* \brief        Integer square root
+* \par          Details
+*               Bit-by-bit floor(sqrt(un_x)), no division.
+* \retval       Square root
+*/
+{
+  uint64_t un_result = 0, un_bit = (uint64_t)1 << 62;
+  while (un_bit > un_x) un_bit >>= 2;
+  while (un_bit != 0) {
+    if (un_x >= un_result + un_bit) {
+      un_x -= un_result + un_bit;
+      un_result = (un_result >> 1) + un_bit;
+    } else {
+      un_result >>= 1;
+    }
+    un_bit >>= 2;
+  }
+  return (uint32_t)un_result;
+}
+
+static int32_t rf_fixed_residuals(const uint32_t *pun_x, int32_t n_size, int32_t n_twice_sum_x2, int32_t *pn_res, int64_t *pn_sum)
+/**
+* \brief        DC removal, linear detrend and headroom scaling
+* \par          Details
+*               Writes x_k - mean - beta*(k-mean_X) in Q4 to pn_res, with beta computed against
+*               n_twice_sum_x2/2 as in rf_linear_regression_beta(), then shifts the residuals right until
+*               n_size squares of the largest one fit in int32.
+* \retval       Right shift applied to pn_res; the raw sum of pun_x is returned in *pn_sum
+*/
+{
+  int32_t k, n_shift, n_limit;
+  int32_t n_mean_q4;
+  int64_t n_sum=0, n_b2=0, n_beta_q12;
+  uint32_t un_max=0;
+
+  for (k=0; k<n_size; ++k) n_sum += pun_x[k];
+  *pn_sum = n_sum;
+  n_mean_q4 = (int32_t)((n_sum*16 + n_size/2)/n_size);
+
+  // sum(d_k*a_k) with d_k doubled to stay integral
+  for (k=0; k<n_size; ++k) {
+    pn_res[k] = (int32_t)(pun_x[k]*16) - n_mean_q4;
+    n_b2 += (int64_t)(2*k - (n_size-1))*pn_res[k];
+  }
+  n_beta_q12 = (n_b2*4096)/n_twice_sum_x2;
+
+  for (k=0; k<n_size; ++k) {
+    pn_res[k] -= (int32_t)((n_beta_q12*(2*k - (n_size-1)) + 4096) >> 13);
+    uint32_t un_abs = pn_res[k] < 0 ? -pn_res[k] : pn_res[k];
+    if (un_abs > un_max) un_max = un_abs;
+  }
+
+  n_limit = rf_isqrt64(INT32_MAX/n_size);
+  for (n_shift=0; (un_max >> n_shift) > (uint32_t)n_limit; ++n_shift);
+  if (n_shift > 0)
+    for (k=0; k<n_size; ++k) pn_res[k] >>= n_shift;
+  return n_shift;
+}
+
+static int32_t rf_fixed_dot(const int32_t *pn_x, const int32_t *pn_y, int32_t n_size)
+{
+  int32_t i, n_sum=0;
+  for (i=0; i<n_size; ++i) n_sum += pn_x[i]*pn_y[i];
+  return n_sum;
+}
+
+void rf_fixed_autocorrelation_all(const int32_t *pn_x, int32_t n_size, int32_t n_first_lag, int32_t n_lags, int32_t *pn_aut)
+/**
+* \brief        Autocorrelation sequence
+* \par          Details
+*               pn_aut[n_lag] = sum(x_i*x_(i+n_lag))/(n_size-n_lag) for n_lag = n_first_lag .. n_lags-1,
+*               0 past the end of the series. Four lags share one walk over pn_x, with
+*               pn_x[i+n_lag..+3] sliding through registers.
+* \retval       None
+*/
+{
+  int32_t i, j, n_lag, n_temp;
+  int32_t x, y0, y1, y2, y3;
+  int32_t as_sum[4];
+
+  for (n_lag=n_first_lag; n_lag<n_lags; n_lag+=4) {
+    as_sum[0]=as_sum[1]=as_sum[2]=as_sum[3]=0;
+    // All four products exist while i+n_lag+3 < n_size
+    n_temp=n_size-n_lag-3;
+    if(n_temp>0) {
+      y0=pn_x[n_lag]; y1=pn_x[n_lag+1]; y2=pn_x[n_lag+2];
+      for (i=0; i<n_temp; ++i) {
+        x=pn_x[i];
+        y3=pn_x[i+n_lag+3];
+        as_sum[0]+=x*y0; as_sum[1]+=x*y1; as_sum[2]+=x*y2; as_sum[3]+=x*y3;
+        y0=y1; y1=y2; y2=y3;
+      }
+    } else n_temp=0;
+    // Tail where only the shorter lags of the block still have a partner
+    for (i=n_temp; i<n_size-n_lag; ++i)
+      for (j=0; j<3 && i+n_lag+j<n_size; ++j) as_sum[j]+=pn_x[i]*pn_x[i+n_lag+j];
+    for (j=0; j<4 && n_lag+j<n_lags; ++j)
+      pn_aut[n_lag+j] = n_lag+j<n_size ? as_sum[j]/(n_size-n_lag-j) : 0;
+  }
+}
+
+static bool rf_fixed_ratio_reached(int32_t n_aut, int32_t n_aut_lag0, int32_t n_ratio_q15)
+{
+  // n_aut/n_aut_lag0 >= n_ratio without dividing (n_aut_lag0 > 0)
+  return ((int64_t)n_aut << 15) >= (int64_t)n_ratio_q15*n_aut_lag0;
+}
+
+static void rf_fixed_initialize_periodicity_search(const int32_t *pn_aut, int32_t *p_last_periodicity, int32_t n_max_distance, int32_t n_min_aut_ratio, int32_t n_aut_lag0)
+/**
+* \brief        Search the range of true signal periodicity
+* \par          Details
+*               Integer twin of rf_initialize_periodicity_search() over an autocorrelation table.
+* \retval       Average distance between peaks
+*/
+{
+  int32_t n_lag;
+  int32_t aut,aut_right;
+  n_lag=*p_last_periodicity;
+  aut_right=aut=pn_aut[n_lag];
+  if(rf_fixed_ratio_reached(aut, n_aut_lag0, n_min_aut_ratio)) {
+    do {
+      aut=aut_right;
+      n_lag+=2;
+      aut_right=pn_aut[n_lag];
+    } while(rf_fixed_ratio_reached(aut_right, n_aut_lag0, n_min_aut_ratio) && aut_right<aut && n_lag<=n_max_distance);
+    if(n_lag>n_max_distance) {
+      *p_last_periodicity=0;
+      return;
+    }
+  }
+  do {
+    n_lag+=2;
+    aut_right=pn_aut[n_lag];
+  } while(!rf_fixed_ratio_reached(aut_right, n_aut_lag0, n_min_aut_ratio) && n_lag<=n_max_distance);
+  if(n_lag>n_max_distance) {
+    *p_last_periodicity=0;
+  } else
+    *p_last_periodicity=n_lag;
+}
+
+static int32_t rf_fixed_signal_periodicity(const int32_t *pn_aut, int32_t *p_last_periodicity, int32_t n_min_distance, int32_t n_max_distance, int32_t n_min_aut_ratio, int32_t n_aut_lag0)
+/**
+* \brief        Signal periodicity
+* \par          Details
+*               Integer twin of rf_signal_periodicity() over an autocorrelation table.
+* \retval       Peak autocorrelation relative to lag 0, Q15
+*/
+{
+  int32_t n_lag;
+  int32_t aut,aut_left,aut_right,aut_save;
+  bool left_limit_reached=false;
+  n_lag=*p_last_periodicity;
+  aut_save=aut=pn_aut[n_lag];
+  aut_left=aut;
+  do {
+    aut=aut_left;
+    n_lag--;
+    aut_left=pn_aut[n_lag];
+  } while(aut_left>aut && n_lag>=n_min_distance);
+  if(n_lag<n_min_distance) {
+    left_limit_reached=true;
+    n_lag=*p_last_periodicity;
+    aut=aut_save;
+  } else n_lag++;
+  if(n_lag==*p_last_periodicity) {
+    aut_right=aut;
+    do {
+      aut=aut_right;
+      n_lag++;
+      aut_right=pn_aut[n_lag];
+    } while(aut_right>aut && n_lag<=n_max_distance);
+    if(n_lag>n_max_distance) n_lag=0;
+    else n_lag--;
+    if(n_lag==*p_last_periodicity && left_limit_reached) n_lag=0;
+  }
+  if(!rf_fixed_ratio_reached(aut, n_aut_lag0, n_min_aut_ratio)) n_lag=0;
+  *p_last_periodicity=n_lag;
+  return (int32_t)(((int64_t)aut << 15)/n_aut_lag0);
+}
+
+void rf_heart_rate_and_oxygen_saturation_fixed(const rf_params_t *pp, const uint32_t *pun_ir_buffer, const uint32_t *pun_red_buffer, int32_t *pn_scratch,
+                                              int32_t *pn_last_peak_interval, float *pn_spo2, int8_t *pch_spo2_valid, int32_t *pn_heart_rate,
+                                              int8_t *pch_hr_valid, float *ratio, float *correl)
+/**
+* \brief        Calculate the heart rate and SpO2 level in fixed point
+* \par          Details
+*               Same steps and thresholds as rf_heart_rate_and_oxygen_saturation(), for the window
+*               length and periods in *pp.
+*
+* \param[in]    *pp                      - Configuration, e.g. &RFConfig<FS, ST>::PARAMS
+* \param[in]    *pun_ir_buffer           - IR sensor data buffer, pp->n_buffer_size samples
+* \param[in]    *pun_red_buffer          - Red sensor data buffer, pp->n_buffer_size samples
+* \param[in]    *pn_scratch              - Work area of RF_FIXED_SCRATCH(CFG) words
+* \param[in,out] *pn_last_peak_interval - Periodicity carried between calls, pp->n_lowest_period initially
+* \param[out]    *pn_spo2                - Calculated SpO2 value
+* \param[out]    *pch_spo2_valid         - 1 if the calculated SpO2 value is valid
+* \param[out]    *pn_heart_rate          - Calculated heart rate value
+* \param[out]    *pch_hr_valid           - 1 if the calculated heart rate value is valid
+*
+* \retval       None
+*/
+{
+  int32_t n_size = pp->n_buffer_size;
+  int32_t *an_x = pn_scratch; //ir
+  int32_t *an_y = an_x + n_size; //red
+  int32_t *an_aut = an_y + n_size;
+  int32_t n_x_shift, n_y_shift, n_xx, n_yy, n_xy;
+  int32_t n_correl_q15, n_ratio_q15 = 0;
+  int64_t n_ir_sum, n_red_sum;
+  uint64_t un_xy_ratio_q16;
+
+  n_x_shift = rf_fixed_residuals(pun_ir_buffer, n_size, pp->n_twice_sum_x2, an_x, &n_ir_sum);
+  n_y_shift = rf_fixed_residuals(pun_red_buffer, n_size, pp->n_twice_sum_x2, an_y, &n_red_sum);
+
+  n_xx = rf_fixed_dot(an_x, an_x, n_size);
+  n_yy = rf_fixed_dot(an_y, an_y, n_size);
+  n_xy = rf_fixed_dot(an_x, an_y, n_size);
+
+  // Pearson correlation between red and IR, independent of the per-channel shifts
+  if (n_xx > 0 && n_yy > 0) {
+    n_correl_q15 = (int32_t)(((int64_t)n_xy << 15)/rf_isqrt64((uint64_t)n_xx*(uint64_t)n_yy));
+  } else {
+    n_correl_q15 = 0;
+  }
+
+  // Find signal periodicity
+  if(n_correl_q15>=n_min_pearson_q15) {
+    // Only the lags the searches can reach, plus lag 0 for the quality ratio
+    an_aut[0] = n_xx/n_size;
+    rf_fixed_autocorrelation_all(an_x, n_size, pp->n_aut_first_lag, pp->n_aut_table_size, an_aut);
+    if(pp->n_lowest_period==*pn_last_peak_interval)
+      rf_fixed_initialize_periodicity_search(an_aut, pn_last_peak_interval, pp->n_highest_period, n_min_aut_ratio_q15, an_aut[0]);
+    if(*pn_last_peak_interval!=0)
+      n_ratio_q15 = rf_fixed_signal_periodicity(an_aut, pn_last_peak_interval, pp->n_lowest_period, pp->n_highest_period, n_min_aut_ratio_q15, an_aut[0]);
+  } else *pn_last_peak_interval=0;
+
+  *correl = (float)n_correl_q15/RF_Q15_ONE;
+  *ratio = (float)n_ratio_q15/RF_Q15_ONE;
+
+  if(*pn_last_peak_interval!=0) {
+    *pn_heart_rate = (int32_t)(pp->n_fs60/(*pn_last_peak_interval));
+    *pch_hr_valid  = 1;
+  } else {
+    *pn_last_peak_interval=pp->n_lowest_period;
+    *pn_heart_rate = -999; // unable to calculate because signal looks aperiodic
+    *pch_hr_valid  = 0;
+    *pn_spo2 =  -999 ; // do not use SPO2 from this corrupt signal
+    *pch_spo2_valid  = 0;
+    return;
+  }
+
+  // (red AC / IR AC) * (IR DC / red DC); the AC ratio is sqrt(yy/xx) undone by the channel shifts
+  un_xy_ratio_q16 = rf_isqrt64(((uint64_t)n_yy << 32)/(uint64_t)n_xx);
+  if (n_y_shift >= n_x_shift) un_xy_ratio_q16 <<= (n_y_shift - n_x_shift);
+  else un_xy_ratio_q16 >>= (n_x_shift - n_y_shift);
+  un_xy_ratio_q16 = n_red_sum > 0 ? un_xy_ratio_q16*(uint64_t)n_ir_sum/(uint64_t)n_red_sum : 0;
+
+  if((int64_t)un_xy_ratio_q16>n_ratio_min_q16 && (int64_t)un_xy_ratio_q16<n_ratio_max_q16) { // Check boundaries of applicability
+    int64_t n_r = (int64_t)un_xy_ratio_q16;
+    int64_t n_spo2_q16 = ((((n_spo2_a_q16*n_r) >> 16) + n_spo2_b_q16)*n_r >> 16) + n_spo2_c_q16;
+    *pn_spo2 = (float)n_spo2_q16/RF_Q16_ONE;
+    *pch_spo2_valid = 1;
+  } else {
+    *pn_spo2 =  -999 ; // do not use SPO2 since signal an_ratio is out of range
+    *pch_spo2_valid  = 0;
+  }
+}
@@ -0,0 +1,47 @@
+/*
+ * Sliding-window variant of rf_heart_rate_and_oxygen_saturation().
+ *
+ * The batch function works on d_k = k - mean_X and on residuals
+ *   e_k = x_k - mean(x) - beta*d_k,  beta = sum(d_k*x_k)/sum_X2
+ * Every sum over e it needs (sum of squares, red/IR cross product and the
+ * autocorrelation at each lag) expands into raw sums of x, k*x and lagged
+ * products x_k*x_(k+lag) plus constants that only depend on the window length.
+ * The raw sums are kept exactly in 64-bit integers by RFStream, so sliding the
+ * window never accumulates rounding error; only the final combination below
+ * runs in floating point.
+ */
+#include "algorithm_by_RF_stream.h"
+
+#if !RF_FIXED_POINT
+double rf_stream_detrended_lag(int32_t n_size, int64_t n_lag_sum, int64_t n_sum, int64_t n_ksum, int32_t n_lag,
+                               int64_t n_head_sum, int64_t n_head_ksum, int64_t n_tail_sum, int64_t n_tail_ksum, double beta)
+/**
+* \brief        Detrended lag product
+* \par          Details
+*               sum(e_i*e_(i+n_lag)) for i = 0 .. n_size-n_lag-1, where n_head_* sum the first
+*               n_lag samples of the window and n_tail_* the last n_lag ones. With n_lag = 0 this is
+*               the plain residual sum of squares.
+* \retval       Sum of lagged residual products
+*/
+{
+  const int64_t N = n_size;
+  const int64_t L = n_lag;
+  const int64_t M = N - L;
+  const int64_t A1 = M*(M-1)/2;           // sum i, i < M
+  const int64_t A2 = M*(M-1)*(2*M-1)/6;   // sum i^2, i < M
+  int64_t n_first = n_sum - n_tail_sum;   // sum x_i, i < M
+  int64_t n_first_k = n_ksum - n_tail_ksum;
+  int64_t n_last = n_sum - n_head_sum;    // sum x_i, i >= L
+  int64_t n_last_k = n_ksum - n_head_ksum;
+
+  // N^2 * sum((x_i - mean)*(x_(i+L) - mean))
+  int64_t n_term1 = N*N*n_lag_sum - N*n_sum*(n_first + n_last) + M*n_sum*n_sum;
+  // 2N * sum(d_i*(x_(i+L) - mean) + d_(i+L)*(x_i - mean))
+  int64_t n_term2 = N*(2*n_last_k - (2*L + N - 1)*n_last) - n_sum*(2*A1 - M*(N-1))
+                  + N*(2*n_first_k + (2*L - (N-1))*n_first) - n_sum*(2*A1 + 2*M*L - M*(N-1));
+  // 4 * sum(d_i*d_(i+L))
+  int64_t n_term3 = 4*A2 - 4*(N-1)*A1 + M*(N-1)*(N-1) + 2*L*(2*A1 - M*(N-1));
+
+  return (double)n_term1/(double)(N*N) - beta*(double)n_term2/(double)(2*N) + beta*beta*(double)n_term3/4.0;
+}
+#endif
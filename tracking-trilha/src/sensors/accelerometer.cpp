@@ -1,6 +1,14 @@
 #include "accelerometer.h"
 #include <string.h>
-#include "utils.h"
+#include <math.h>
+#include "state_collect.h"
+
+static_assert(sizeof(imuFrame_t) == 2 + 2 * IMU_CHANNEL_QTT, "IMU frames must stay packed");
+// Update() drains the FIFO once per state tick; it must not fill up in between, even at the slowest profile
+static_assert(ACCEL_ODR_HZ * STATE_MAX_UPDATE_PERIOD_MS / 1000 < IMU6050_FIFO_MAX_FRAMES, "IMU6050 FIFO overflows between two updates");
+
+// Weight of a new sample in the motion variance, about MOTION_WINDOW_MS of memory
+#define ACCEL_MOTION_ALPHA (1000.0f / (MOTION_WINDOW_MS * ACCEL_ODR_HZ))
 
 Accelerometer::Accelerometer() : Sensor() {
   busy_wait_ms(500);
@@ -9,65 +17,196 @@ Accelerometer::Accelerometer() : Sensor() {
         printf("IMU6050 not connect r fail load calib coeff \r\n");
         busy_wait_ms(500);
     }
+    while (imuSensor.enable_fifo(ACCEL_ODR_HZ) != true)
+    {
+        printf("IMU6050 FIFO setup failed \r\n");
+        busy_wait_ms(500);
+    }
 
     sensorType = SENSOR_TYPE_ACCELEROMETER;
+
+    // g, °C and °/s, the units the IMU6050 convert_* helpers use
+    samples.SetScale(IMU_CHANNEL_ACCEL_X, 1.0f / ACCEL_RANGE_2G);
+    samples.SetScale(IMU_CHANNEL_ACCEL_Y, 1.0f / ACCEL_RANGE_2G);
+    samples.SetScale(IMU_CHANNEL_ACCEL_Z, 1.0f / ACCEL_RANGE_2G);
+    samples.SetScale(IMU_CHANNEL_TEMP, 1.0f / 340.0f, 36.53f);
+    samples.SetScale(IMU_CHANNEL_GYRO_X, 1.0f / GYRO_RANGE_250);
+    samples.SetScale(IMU_CHANNEL_GYRO_Y, 1.0f / GYRO_RANGE_250);
+    samples.SetScale(IMU_CHANNEL_GYRO_Z, 1.0f / GYRO_RANGE_250);
+
+    roundFrames = {};
+    roundActive = false;
+    roundReleased = 0;
+
+    motionMean = 1.0f;  // at rest the magnitude is gravity
+    motionVariance = 0.0f;
 }
 
 void Accelerometer::Update() {
-    imu6050_data_t raw_data;
-    imu6050_calibrated_t calibrated_data;
+    // Ler todos os quadros acumulados na FIFO desde a última chamada
+    int count = imuSensor.read_frames(fifoFrames, IMU6050_FIFO_MAX_FRAMES);
+    if (count < 0) {
+        printf("IMU6050 FIFO overflow, stream restarted\n");
+        return;
+    }
 
-    // Ler dados do acelerômetro
-    imuSensor.read_accelerometer(&raw_data);
+    // Quadros saem da FIFO a ACCEL_ODR_HZ, o último é o mais recente
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    for (int i = 0; i < count; i++) {
+        const imu6050_frame_t* frame = &fifoFrames[i];
+        int16_t raw[IMU_CHANNEL_QTT] = {
+            frame->accel.x, frame->accel.y, frame->accel.z,
+            frame->temperature,
+            frame->gyro.x, frame->gyro.y, frame->gyro.z
+        };
+        samples.Push(now - (uint32_t)(count - 1 - i) * 1000 / ACCEL_ODR_HZ, raw);
 
-    // Converter dados brutos para unidades físicas (g)
-    imuSensor.convert_accelerometer_data(&raw_data, &calibrated_data);
+        float x = raw[IMU_CHANNEL_ACCEL_X] / ACCEL_RANGE_2G;
+        float y = raw[IMU_CHANNEL_ACCEL_Y] / ACCEL_RANGE_2G;
+        float z = raw[IMU_CHANNEL_ACCEL_Z] / ACCEL_RANGE_2G;
+        stepCounter.Push(x, y, z);
 
-    if (buffer_size_accel_x >= MAX_BUFFER_SIZE) {
-      shift_buffer(buffer_accel_x, &buffer_size_accel_x);
+        // Exponentially weighted mean and variance of the magnitude
+        float deviation = sqrtf(x * x + y * y + z * z) - motionMean;
+        motionMean += ACCEL_MOTION_ALPHA * deviation;
+        motionVariance = (1.0f - ACCEL_MOTION_ALPHA) * (motionVariance + ACCEL_MOTION_ALPHA * deviation * deviation);
     }
-    if (buffer_size_accel_y >= MAX_BUFFER_SIZE) {
-      shift_buffer(buffer_accel_y, &buffer_size_accel_y);
-    }
-    if (buffer_size_accel_z >= MAX_BUFFER_SIZE) {
-      shift_buffer(buffer_accel_z, &buffer_size_accel_z);
+
+    if (count > 0) {
+        motion.Publish(motionVariance, now);
+        buffer_steps.Push((float)stepCounter.Steps());
+        buffer_cadence.Push(stepCounter.Cadence());
+        Publish();
     }
-    // Armazenar dados nos buffers
-    buffer_accel_x[buffer_size_accel_x++] = calibrated_data.x;
-    buffer_accel_y[buffer_size_accel_y++] = calibrated_data.y;
-    buffer_accel_z[buffer_size_accel_z++] = calibrated_data.z;
 }
 
-bool Accelerometer::getData(Data_t* data) {
-    switch (data->type) {
+// Frame channels first, then the samples derived from them
+static const sample_t accelerometerSamples[] = {
+    SAMPLE_TYPE_ACCEL_X,
+    SAMPLE_TYPE_ACCEL_Y,
+    SAMPLE_TYPE_ACCEL_Z,
+    SAMPLE_TYPE_GYRO_X,
+    SAMPLE_TYPE_GYRO_Y,
+    SAMPLE_TYPE_GYRO_Z,
+    SAMPLE_TYPE_IMU_TEMP,
+    SAMPLE_TYPE_STEPS,
+    SAMPLE_TYPE_CADENCE
+};
+
+size_t Accelerometer::GetSampleTypes(const sample_t** types) {
+    *types = accelerometerSamples;
+    return sizeof(accelerometerSamples) / sizeof(accelerometerSamples[0]);
+}
+
+int Accelerometer::GetChannel(sample_t type) {
+    switch (type) {
         case SAMPLE_TYPE_ACCEL_X:
-            if (buffer_size_accel_x == 0) {
-                return false;
-            }
-            data->data = buffer_accel_x;
-            data->size = buffer_size_accel_x;
-            buffer_size_accel_x = 0;
-            break;
+            return IMU_CHANNEL_ACCEL_X;
         case SAMPLE_TYPE_ACCEL_Y:
-            if (buffer_size_accel_y == 0) {
-                return false;
-            }
-            data->data = buffer_accel_y;
-            data->size = buffer_size_accel_y;
-            buffer_size_accel_y = 0;
-            break;
+            return IMU_CHANNEL_ACCEL_Y;
         case SAMPLE_TYPE_ACCEL_Z:
-            if (buffer_size_accel_z == 0) {
-                return false;
-            }
-            data->data = buffer_accel_z;
-            data->size = buffer_size_accel_z;
-            buffer_size_accel_z = 0;
-            break;
+            return IMU_CHANNEL_ACCEL_Z;
+        case SAMPLE_TYPE_GYRO_X:
+            return IMU_CHANNEL_GYRO_X;
+        case SAMPLE_TYPE_GYRO_Y:
+            return IMU_CHANNEL_GYRO_Y;
+        case SAMPLE_TYPE_GYRO_Z:
+            return IMU_CHANNEL_GYRO_Z;
+        case SAMPLE_TYPE_IMU_TEMP:
+            return IMU_CHANNEL_TEMP;
+        default:
+            return -1;
+    }
+}
+
+// Derived samples that are not frame channels
+SampleBuffer* Accelerometer::GetBuffer(sample_t type) {
+    switch (type) {
+        case SAMPLE_TYPE_STEPS:
+            return &buffer_steps;
+        case SAMPLE_TYPE_CADENCE:
+            return &buffer_cadence;
         default:
-            return false;
+            return nullptr;
+    }
+}
+
+bool Accelerometer::BeginRound() {
+    if (!roundActive) {
+        roundReleased = 0;
+        roundActive = samples.Acquire(&roundFrames) > 0;
+    }
+    return roundActive;
+}
+
+void Accelerometer::EndRound() {
+    if (roundActive) {
+        samples.Release(roundFrames.Size());
+        roundActive = false;
+        roundReleased = 0;
+    }
+}
+
+// Every axis of one round covers the same frames, so X, Y and Z stay in step
+bool Accelerometer::getData(Data_t* data) {
+    SampleBuffer* buffer = GetBuffer(data->type);
+    if (buffer != nullptr) {
+        data->size = buffer->Acquire(&data->data);
+        data->timestamp = to_ms_since_boot(get_absolute_time());
+        return data->size > 0;
+    }
+
+    int channel = GetChannel(data->type);
+    if (channel < 0) {
+        return false;
+    }
+
+    // Asking for an axis again means the consumer moved on to newer data
+    if (roundReleased & (1u << channel)) {
+        EndRound();
+    }
+    if (!BeginRound()) {
+        return false;
     }
 
+    data->size = samples.CopyChannel(roundFrames, channel, axisData);
+    data->data = axisData;
     data->timestamp = to_ms_since_boot(get_absolute_time());
     return true;
-}
\ No newline at end of file
+}
+
+bool Accelerometer::releaseData(Data_t* data) {
+    SampleBuffer* buffer = GetBuffer(data->type);
+    if (buffer != nullptr) {
+        return buffer->Release(data->size);
+    }
+
+    int channel = GetChannel(data->type);
+    if (channel < 0 || !roundActive) {
+        return false;
+    }
+
+    bool intact = samples.Intact();
+    roundReleased |= 1u << channel;
+    if (roundReleased == (1u << IMU_CHANNEL_QTT) - 1) {
+        EndRound();
+    }
+    return intact;
+}
+
+size_t Accelerometer::getFrames(imuFrameView_t* frames) {
+    if (!BeginRound()) {
+        return 0;
+    }
+    *frames = roundFrames;
+    return roundFrames.Size();
+}
+
+bool Accelerometer::releaseFrames() {
+    if (!roundActive) {
+        return false;
+    }
+    bool intact = samples.Intact();
+    EndRound();
+    return intact;
+}
@@ -1,7 +1,17 @@
 #include "oximeter.h"
-#include "utils.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include <stdlib.h>
 
-MAX3010X heartSensor(I2C_PORT_OXI, PIN_WIRE_SDA_OXI, PIN_WIRE_SCL_OXI, I2C_SPEED_FAST);
+static_assert(OXIMETER_FIFO_RATE % OximeterRF::FS == 0, "Oximeter FIFO rate must be a multiple of the HR/SpO2 rate");
+static_assert(MOTION_WINDOW_MS == OXIMETER_WINDOW_SECONDS * 1000, "Motion gate must look at the HR/SpO2 window");
+static_assert(OXIMETER_INT_SAMPLES >= OXIMETER_DECIMATION, "Oximeter INT batch must hold an algorithm sample");
+static_assert(MAX3010X_FIFO_DEPTH - OXIMETER_INT_SAMPLES <= 0x0F, "Oximeter INT batch must fit the 4-bit A_FULL field");
+static_assert(OXIMETER_INT_SAMPLES <= MAX3010X_FIFO_DEPTH / 2 + 1, "Oximeter INT batch must leave FIFO headroom");
+
+MAX3010X<> heartSensor(I2C_PORT_OXI, PIN_WIRE_SDA_OXI, PIN_WIRE_SCL_OXI, I2C_SPEED_FAST);
+
+Oximeter* Oximeter::intTarget = nullptr;
 
 Oximeter::Oximeter() : Sensor() {
   busy_wait_ms(500);
@@ -13,24 +23,88 @@ Oximeter::Oximeter() : Sensor() {
   sensorType = SENSOR_TYPE_OXIMETER;
 
 	uint8_t powerLevel = 0x1f; //Options: 0=Off to 255=50mA
-	uint8_t sampleAverage = 0x04; //Options: 1, 2, 4, 8, 16, 32
+	uint8_t sampleAverage = OXIMETER_SAMPLE_AVERAGE; //Options: 1, 2, 4, 8, 16, 32
 	uint8_t ledMode = 0x03; //Options: 1 = Red only, 2 = Red + IR, 3 = Red + IR + Green
-	int sampleRate = 1600; //Options: 50, 100, 200, 400, 800, 1000, 1600, 3200
+	int sampleRate = OXIMETER_SAMPLE_RATE; //Options: 50, 100, 200, 400, 800, 1000, 1600, 3200
 	int pulseWidth = 411; //Options: 69, 118, 215, 411
 	int adcRange = 4096; //Options: 2048, 4096, 8192, 16384
 	heartSensor.setup(powerLevel, sampleAverage, ledMode, sampleRate, pulseWidth, adcRange);
+	if (!heartSensor.enableBurstDMA()) {
+		printf("MAX3010X burst DMA unavailable, using blocking FIFO reads\r\n");
+	}
+
+	// Raise INT once an algorithm sample worth of FIFO entries is waiting (A_FULL counts free slots)
+	heartSensor.setFIFOAlmostFull(MAX3010X_FIFO_DEPTH - OXIMETER_INT_SAMPLES);
+	heartSensor.enableAFULL();
+
+	samplesSinceResult = 0;
+	hopSamples = OXIMETER_HOP_SAMPLES;
+	requestedProfile = nullptr;
+	appliedProfile = nullptr;
+	heartRateDelta = 0.0f;
+	lastHeartRate = 0;
+	motion = nullptr;
+	skippedWindows = 0;
+	ch_spo2_valid = 0;
+	ch_hr_valid = 0;
+	temperature = 0;
+	lastTemperatureMs = 0;
 	
 	// Initialize FreeRTOS components
-	taskHandle = nullptr;
-	dataMutex = xSemaphoreCreateMutex();
+	ioTaskHandle = nullptr;
+	dspTaskHandle = nullptr;
 	taskRunning = false;
+
+	intTarget = this;
+	gpio_init(PIN_INT_OXI);
+	gpio_set_dir(PIN_INT_OXI, GPIO_IN);
+	gpio_pull_up(PIN_INT_OXI);
+	gpio_add_raw_irq_handler(PIN_INT_OXI, &Oximeter::IntHandler);
+	gpio_set_irq_enabled(PIN_INT_OXI, GPIO_IRQ_EDGE_FALL, true);
+	irq_set_enabled(IO_IRQ_BANK0, true);
 }
 
 Oximeter::~Oximeter() {
 	StopTask();
-	if (dataMutex != nullptr) {
-		vSemaphoreDelete(dataMutex);
-	}
+	gpio_set_irq_enabled(PIN_INT_OXI, GPIO_IRQ_EDGE_FALL, false);
+	intTarget = nullptr;
+}
+
+void Oximeter::IntHandler() {
+  if (!(gpio_get_irq_event_mask(PIN_INT_OXI) & GPIO_IRQ_EDGE_FALL)) {
+    return;
+  }
+  gpio_acknowledge_irq(PIN_INT_OXI, GPIO_IRQ_EDGE_FALL);
+
+  BaseType_t higherPriorityTaskWoken = pdFALSE;
+  if (intTarget != nullptr && intTarget->ioTaskHandle != nullptr) {
+    vTaskNotifyGiveFromISR(intTarget->ioTaskHandle, &higherPriorityTaskWoken);
+  }
+  portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+static const sample_t oximeterSamples[] = {
+  SAMPLE_TYPE_SPO2,
+  SAMPLE_TYPE_HEART_RATE,
+  SAMPLE_TYPE_TEMPERATURE
+};
+
+size_t Oximeter::GetSampleTypes(const sample_t** types) {
+  *types = oximeterSamples;
+  return sizeof(oximeterSamples) / sizeof(oximeterSamples[0]);
+}
+
+SampleBuffer* Oximeter::GetBuffer(sample_t type) {
+  switch (type) {
+    case SAMPLE_TYPE_SPO2:
+      return &buffer_spO2;
+    case SAMPLE_TYPE_HEART_RATE:
+      return &buffer_heart_rate;
+    case SAMPLE_TYPE_TEMPERATURE:
+      return &buffer_temperature;
+    default:
+      return nullptr;
+  }
 }
 
 bool Oximeter::getData(Data_t* data) {
@@ -38,115 +112,157 @@ bool Oximeter::getData(Data_t* data) {
     return false;
   }
 
-  // Take mutex to safely access shared data
-  if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
-    bool result = false;
-    
-    switch (data->type) {
-      case SAMPLE_TYPE_SPO2:
-        if (buffer_size_spO2 == 0) {
-          result = false;
-        } else {
-          data->data = buffer_spO2;
-          data->size = buffer_size_spO2;
-          buffer_size_spO2 = 0;
-          result = true;
-        }
-        break;
-      case SAMPLE_TYPE_HEART_RATE:
-        if (buffer_size_heart_rate == 0) {
-          result = false;
-        } else {
-          data->data = buffer_heart_rate;
-          data->size = buffer_size_heart_rate;
-          buffer_size_heart_rate = 0;
-          result = true;
-        }
-        break;
-      case SAMPLE_TYPE_TEMPERATURE:
-        if (buffer_size_temperature == 0) {
-          result = false;
-        } else {
-          data->data = buffer_temperature;
-          data->size = buffer_size_temperature;
-          buffer_size_temperature = 0;
-          result = true;
-        }
-        break;
-      default:
-        result = false;
-    }
+  SampleBuffer* buffer = GetBuffer(data->type);
+  if (buffer == nullptr) {
+    return false;
+  }
 
-    data->timestamp = to_ms_since_boot(get_absolute_time());
-    
-    xSemaphoreGive(dataMutex);
-    return result;
+  // Zero-copy view into the ring; OximeterDSPTask keeps pushing while it is held
+  data->size = buffer->Acquire(&data->data);
+  if (data->size == 0) {
+    return false;
   }
-  
-  return false;
+  data->timestamp = to_ms_since_boot(get_absolute_time());
+  return true;
+}
+
+bool Oximeter::releaseData(Data_t* data) {
+  SampleBuffer* buffer = GetBuffer(data->type);
+  if (buffer == nullptr) {
+    return false;
+  }
+  return buffer->Release(data->size);
 }
 
 void Oximeter::Update() {
   // This method is now deprecated - use StartTask() instead
-  // For backward compatibility, call UpdateInternal directly
-  UpdateInternal();
-}
-
-void Oximeter::UpdateInternal() {
-  uint32_t aun_ir_buffer[BUFFER_SIZE_ALGORITHM]; //infrared LED sensor data
-  uint32_t aun_red_buffer[BUFFER_SIZE_ALGORITHM];  //red LED sensor data
-  
-  // Collect samples with minimal delay - use FIFO data when available
-  for(int i=0;i<BUFFER_SIZE_ALGORITHM;i++) { //store the samples in the memory
-    // Check if new data is available in FIFO
-    if(heartSensor.available() > 0) {
-      aun_red_buffer[i] = heartSensor.getFIFORed();
-      aun_ir_buffer[i] = heartSensor.getFIFOIR();
-      heartSensor.nextSample();
-    } else {
-      // Fallback to immediate readings with shorter timeout
-      aun_red_buffer[i] = heartSensor.getRed();
-      aun_ir_buffer[i] = heartSensor.getIR();
+  // For backward compatibility, run both halves of the pipeline directly
+  AcquireSamples();
+  ProcessSamples();
+}
+
+void Oximeter::SetProfile(const oximeterProfile_t* profile) {
+  requestedProfile.store(profile, std::memory_order_release);
+}
+
+// I/O task only: the sensor registers are never written from two tasks
+void Oximeter::ApplyProfile() {
+  const oximeterProfile_t* profile = requestedProfile.load(std::memory_order_acquire);
+  if (profile == nullptr || profile == appliedProfile) {
+    return;
+  }
+
+  if (profile->sampleRate / profile->sampleAverage != OXIMETER_FIFO_RATE) {
+    printf("Oximeter profile %u Hz / %u rejected, FIFO rate must stay %u Hz\n",
+           profile->sampleRate, profile->sampleAverage, OXIMETER_FIFO_RATE);
+    appliedProfile = profile;
+    return;
+  }
+
+  heartSensor.setAcquisition(profile->ledAmplitude, profile->sampleAverage, profile->sampleRate);
+  hopSamples.store(profile->hopSamples, std::memory_order_relaxed);
+  appliedProfile = profile;
+}
+
+// I/O side: everything that touches the I2C bus
+void Oximeter::AcquireSamples() {
+  uint32_t aun_ir_buffer[MAX3010X_STORAGE_SIZE]; //infrared LED sensor data
+  uint32_t aun_red_buffer[MAX3010X_STORAGE_SIZE];  //red LED sensor data
+
+  // Sleep until the sensor signals a batch of samples; a missed edge only
+  // costs one timeout since the FIFO is drained either way
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(OXIMETER_INT_TIMEOUT_MS));
+  heartSensor.getINT1(); // reading the status register releases INT
+  ApplyProfile();
+  heartSensor.check();
+
+  uint16_t count = heartSensor.readSamples(aun_red_buffer, aun_ir_buffer, nullptr, MAX3010X_STORAGE_SIZE);
+  for (uint16_t i = 0; i < count; i++) {
+    if (!rawSamples.Push({aun_ir_buffer[i], aun_red_buffer[i]})) {
+      printf("Oximeter DSP behind, dropped raw samples: %lu\n", (unsigned long)rawSamples.Dropped());
+      break;
+    }
+  }
+
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+  if (lastTemperatureMs == 0 || now - lastTemperatureMs >= OXIMETER_TEMPERATURE_PERIOD_MS) {
+    temperature.store(heartSensor.readTemperature(), std::memory_order_relaxed);
+    lastTemperatureMs = now;
+  }
+
+  if (count > 0 && dspTaskHandle != nullptr) {
+    xTaskNotifyGive(dspTaskHandle);
+  }
+}
+
+// DSP side: decimation and HR/SpO2, no bus access
+void Oximeter::ProcessSamples() {
+  oximeterSample_t raw[MAX3010X_STORAGE_SIZE];
+  uint32_t aun_ir_buffer[MAX3010X_STORAGE_SIZE];
+  uint32_t aun_red_buffer[MAX3010X_STORAGE_SIZE];
+  uint32_t aun_ir_decimated[MAX3010X_STORAGE_SIZE / OXIMETER_DECIMATION + 1];
+  uint32_t aun_red_decimated[MAX3010X_STORAGE_SIZE / OXIMETER_DECIMATION + 1];
+
+  size_t count;
+  while ((count = rawSamples.ReadAll(raw, MAX3010X_STORAGE_SIZE)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      aun_ir_buffer[i] = raw[i].ir;
+      aun_red_buffer[i] = raw[i].red;
+    }
+
+    // Both decimators get the same number of inputs, so their outputs stay paired
+    size_t decimated = decimatorIR.Process(aun_ir_buffer, count, aun_ir_decimated);
+    decimatorRed.Process(aun_red_buffer, count, aun_red_decimated);
+
+    for (size_t i = 0; i < decimated; i++) {
+      stream.Push(aun_ir_decimated[i], aun_red_decimated[i]);
+
+      if (++samplesSinceResult >= hopSamples.load(std::memory_order_relaxed) && stream.Ready()) {
+        samplesSinceResult = 0;
+        if (MotionTooHigh()) {
+          // Deferred: the window slides on and the next hop checks again. Single writer, so
+          // load + store instead of a read-modify-write the Cortex-M0+ has no instruction for
+          skippedWindows.store(skippedWindows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+          PublishResult();
+        }
+      }
     }
-    // Small delay to allow sensor to collect new samples
-    busy_wait_us(625); // 625us = 1/1600Hz for 1600Hz sample rate
   }
+}
+
+// Non-blocking: the accelerometer publishes on another core, a missing or stale value lets the window through
+bool Oximeter::MotionTooHigh() {
+  float variance;
+  if (motion == nullptr ||
+      !motion->Read(to_ms_since_boot(get_absolute_time()), OXIMETER_MOTION_MAX_AGE_MS, &variance)) {
+    return false;
+  }
+  return variance > OXIMETER_MOTION_GATE_G * OXIMETER_MOTION_GATE_G;
+}
 
+void Oximeter::PublishResult() {
   float ratio,correl;
-  rf_heart_rate_and_oxygen_saturation(
-    aun_ir_buffer,
-    BUFFER_SIZE_ALGORITHM,
-    aun_red_buffer,
+  stream.Compute(
     &n_spo2,
     &ch_spo2_valid,
     &n_heart_rate,
     &ch_hr_valid,
     &ratio,
     &correl
-  ); 
-  //maxim_heart_rate_and_oxygen_saturation(aun_ir_buffer, BUFFER_SIZE, aun_red_buffer, &n_spo2, &ch_spo2_valid, &n_heart_rate, &ch_hr_valid);
-
-  float temperature = heartSensor.readTemperature();
+  );
 
   if (is_valid()) {
-    // Take mutex to safely update shared data
-    if (xSemaphoreTake(dataMutex, portMAX_DELAY) == pdTRUE) {
-      if (buffer_size_spO2 >= MAX_BUFFER_SIZE) {
-        shift_buffer(buffer_spO2, &buffer_size_spO2);
-      }
-      if (buffer_size_heart_rate >= MAX_BUFFER_SIZE) {
-        shift_buffer(buffer_heart_rate, &buffer_size_heart_rate);
-      }
-      if (buffer_size_temperature >= MAX_BUFFER_SIZE) {
-        shift_buffer(buffer_temperature, &buffer_size_temperature);
-      }
-
-      buffer_spO2[buffer_size_spO2++] = n_spo2;
-      buffer_heart_rate[buffer_size_heart_rate++] = n_heart_rate;
-      buffer_temperature[buffer_size_temperature++] = temperature;
-      
-      xSemaphoreGive(dataMutex);
+    if (lastHeartRate != 0) {
+      float delta = (float)abs(n_heart_rate - lastHeartRate);
+      heartRateDelta.store(0.8f * heartRateDelta.load(std::memory_order_relaxed) + 0.2f * delta, std::memory_order_relaxed);
     }
+    lastHeartRate = n_heart_rate;
+
+    buffer_spO2.Push(n_spo2);
+    buffer_heart_rate.Push(n_heart_rate);
+    buffer_temperature.Push(temperature.load(std::memory_order_relaxed));
+    Publish();
   }
 }
 
@@ -155,50 +271,77 @@ bool Oximeter::is_valid() {
 }
 
 void Oximeter::StartTask() {
-  if (taskHandle == nullptr && dataMutex != nullptr) {
+  if (ioTaskHandle == nullptr) {
     taskRunning = true;
     BaseType_t result = xTaskCreate(
-      OximeterTask,
-      "OximeterTask",
-      OXIMETER_TASK_STACK_SIZE,
+      OximeterDSPTask,
+      "OximeterDSP",
+      OXIMETER_DSP_TASK_STACK_SIZE,
       this,
-      OXIMETER_TASK_PRIORITY,
-      &taskHandle
+      OXIMETER_DSP_TASK_PRIORITY,
+      &dspTaskHandle
     );
-    
+
+    if (result == pdPASS) {
+      PinTaskToCore(dspTaskHandle, CORE_DSP);
+      result = xTaskCreate(
+        OximeterIOTask,
+        "OximeterIO",
+        OXIMETER_IO_TASK_STACK_SIZE,
+        this,
+        OXIMETER_IO_TASK_PRIORITY,
+        &ioTaskHandle
+      );
+    }
+
     if (result != pdPASS) {
       printf("Failed to create Oximeter task\n");
-      taskRunning = false;
-      taskHandle = nullptr;
+      StopTask();
     } else {
+      PinTaskToCore(ioTaskHandle, CORE_IO);
       printf("Oximeter task created successfully\n");
     }
   }
 }
 
 void Oximeter::StopTask() {
-  if (taskHandle != nullptr) {
-    taskRunning = false;
-    vTaskDelete(taskHandle);
-    taskHandle = nullptr;
+  taskRunning = false;
+  if (ioTaskHandle != nullptr) {
+    vTaskDelete(ioTaskHandle);
+    ioTaskHandle = nullptr;
+  }
+  if (dspTaskHandle != nullptr) {
+    vTaskDelete(dspTaskHandle);
+    dspTaskHandle = nullptr;
     printf("Oximeter task stopped\n");
   }
 }
 
-void Oximeter::OximeterTask(void* pvParameters) {
+void Oximeter::OximeterIOTask(void* pvParameters) {
   Oximeter* oximeter = static_cast<Oximeter*>(pvParameters);
-  TickType_t xLastWakeTime = xTaskGetTickCount();
-  
-  printf("Oximeter task started\n");
-  
+
+  printf("Oximeter I/O task started\n");
+
+  // Paced by the sensor INT line: every pass blocks until new samples arrive
   while (oximeter->taskRunning) {
-    oximeter->UpdateInternal();
-    
-    // Wait for the next period
-    vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(OXIMETER_UPDATE_PERIOD_MS));
+    oximeter->AcquireSamples();
   }
-  
-  printf("Oximeter task ending\n");
+
+  printf("Oximeter I/O task ending\n");
   vTaskDelete(nullptr);
 }
 
+void Oximeter::OximeterDSPTask(void* pvParameters) {
+  Oximeter* oximeter = static_cast<Oximeter*>(pvParameters);
+
+  printf("Oximeter DSP task started\n");
+
+  // Paced by the I/O task, which notifies after every batch it hands over
+  while (oximeter->taskRunning) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    oximeter->ProcessSamples();
+  }
+
+  printf("Oximeter DSP task ending\n");
+  vTaskDelete(nullptr);
+}
@@ -0,0 +1,101 @@
+#include "step_counter.h"
+#include <math.h>
+
+StepCounter::StepCounter(float sampleRateHz) {
+    sampleRate = sampleRateHz;
+    minInterval = (uint32_t)(STEP_COUNTER_MIN_INTERVAL_MS * sampleRateHz / 1000.0f);
+    maxInterval = (uint32_t)(STEP_COUNTER_MAX_INTERVAL_MS * sampleRateHz / 1000.0f);
+
+    // Band-pass with 0 dB peak gain, centred between the edges (RBJ cookbook)
+    float centre = sqrtf(STEP_COUNTER_LOW_HZ * STEP_COUNTER_HIGH_HZ);
+    float octaves = log2f(STEP_COUNTER_HIGH_HZ / STEP_COUNTER_LOW_HZ);
+    float w0 = 2.0f * (float)M_PI * centre / sampleRateHz;
+    float alpha = sinf(w0) * sinhf(logf(2.0f) / 2.0f * octaves * w0 / sinf(w0));
+    float a0 = 1.0f + alpha;
+    b0 = alpha / a0;
+    b2 = -alpha / a0;
+    a1 = -2.0f * cosf(w0) / a0;
+    a2 = (1.0f - alpha) / a0;
+
+    // Threshold halves in about 2 seconds without steps
+    peakDecay = powf(0.5f, 1.0f / (2.0f * sampleRateHz));
+    energyAlpha = 1.0f / sampleRateHz;
+
+    Reset();
+}
+
+void StepCounter::Reset() {
+    x1 = x2 = y1 = y2 = 0.0f;
+    previous = beforePrevious = 0.0f;
+    peakAverage = 0.0f;
+    energy = 0.0f;
+    sinceStep = maxInterval + 1;
+    walking = false;
+    pending = 0;
+    intervalAverage = 0.0f;
+    steps = 0;
+}
+
+bool StepCounter::Push(float x, float y, float z) {
+    float magnitude = sqrtf(x * x + y * y + z * z);
+    float filtered = b0 * magnitude + b2 * x2 - a1 * y1 - a2 * y2;
+    x2 = x1;
+    x1 = magnitude;
+    y2 = y1;
+    y1 = filtered;
+    energy += energyAlpha * (filtered * filtered - energy);
+
+    if (sinceStep <= maxInterval) {
+        sinceStep++;
+    }
+    peakAverage *= peakDecay;
+
+    float threshold = STEP_COUNTER_THRESHOLD_RATIO * peakAverage;
+    if (threshold < STEP_COUNTER_MIN_THRESHOLD_G) {
+        threshold = STEP_COUNTER_MIN_THRESHOLD_G;
+    }
+
+    // The previous sample is a step if it is a local maximum above the threshold
+    bool peak = previous > threshold && previous > beforePrevious && previous >= filtered;
+    float height = previous;
+    beforePrevious = previous;
+    previous = filtered;
+
+    if (!peak || sinceStep < minInterval) {
+        return false;
+    }
+
+    peakAverage += 0.25f * (height - peakAverage);
+
+    bool credited = false;
+    if (sinceStep > maxInterval) {
+        // First step after a pause, the walk has to be confirmed again
+        walking = false;
+        pending = 1;
+        intervalAverage = 0.0f;
+    } else {
+        intervalAverage = (intervalAverage == 0.0f) ? sinceStep : 0.75f * intervalAverage + 0.25f * sinceStep;
+        if (walking) {
+            steps++;
+            credited = true;
+        } else if (++pending >= STEP_COUNTER_CONFIRM_STEPS) {
+            steps += pending;
+            pending = 0;
+            walking = true;
+            credited = true;
+        }
+    }
+    sinceStep = 0;
+    return credited;
+}
+
+float StepCounter::Cadence() const {
+    if (!walking || sinceStep > maxInterval || intervalAverage == 0.0f) {
+        return 0.0f;
+    }
+    return 60.0f * sampleRate / intervalAverage;
+}
+
+float StepCounter::Intensity() const {
+    return sqrtf(energy);
+}
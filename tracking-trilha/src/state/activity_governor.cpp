@@ -0,0 +1,52 @@
+#include "activity_governor.h"
+
+// REST trades ADC rate for averaging-free samples at a lower LED current; every
+// profile keeps the FIFO at OXIMETER_FIFO_RATE. RUNNING is the original fixed setup.
+const activityProfile_t ActivityGovernor::profiles[ACTIVITY_PROFILE_QTT] = {
+    {"rest",    {400,  1, 0x10, 25}, 500},
+    {"walking", {800,  2, 0x1F, 10}, 200},
+    {"running", {1600, 4, 0x3F, OXIMETER_HOP_SAMPLES}, 100},
+};
+
+ActivityGovernor::ActivityGovernor() {
+    // Start with the most capable profile until the sensors have seen enough
+    current = ACTIVITY_PROFILE_RUNNING;
+    lowering = false;
+    lowerSinceMs = 0;
+    transitions = 0;
+}
+
+bool ActivityGovernor::Update(uint32_t nowMs, float cadence, float intensity, float heartRateDelta) {
+    activityProfileId_t wanted = ACTIVITY_PROFILE_REST;
+    if (cadence >= GOVERNOR_RUN_CADENCE || intensity >= GOVERNOR_RUN_INTENSITY_G) {
+        wanted = ACTIVITY_PROFILE_RUNNING;
+    } else if (cadence >= GOVERNOR_WALK_CADENCE || intensity >= GOVERNOR_WALK_INTENSITY_G) {
+        wanted = ACTIVITY_PROFILE_WALKING;
+    }
+    // An unsettled heart rate needs frequent results even when standing still
+    if (heartRateDelta >= GOVERNOR_HR_UNSTABLE_BPM && wanted < ACTIVITY_PROFILE_WALKING) {
+        wanted = ACTIVITY_PROFILE_WALKING;
+    }
+
+    if (wanted >= current) {
+        lowering = false;
+        if (wanted == current) {
+            return false;
+        }
+    } else {
+        if (!lowering) {
+            lowering = true;
+            lowerSinceMs = nowMs;
+        }
+        if (nowMs - lowerSinceMs < GOVERNOR_HOLD_MS) {
+            return false;
+        }
+        lowering = false;
+    }
+
+    printf("Governor: %s -> %s (cadence %.0f spm, motion %.3f g, HR delta %.1f bpm)\n",
+           profiles[current].name, profiles[wanted].name, cadence, intensity, heartRateDelta);
+    current = wanted;
+    transitions++;
+    return true;
+}
@@ -1,50 +1,93 @@
 #include "state.h"
 
-State::State() : popRequested(false), quitRequested(false) {
+State::State() : rejected(0), popRequested(false), quitRequested(false) {
     for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
         sensorArray[i] = nullptr;
-        analyzerArray[i] = nullptr;
+        for (size_t j = 0; j < SAMPLE_TYPE_QTT; j++) {
+            analyzerCount[i][j] = 0;
+            for (size_t k = 0; k < STATE_MAX_ANALYZERS_PER_SAMPLE; k++) {
+                analyzerTable[i][j][k] = nullptr;
+            }
+        }
     }
 }
 
 bool State::AddSensor(Sensor* sensor) {
-    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
-        if (sensorArray[i] == nullptr) {
-            sensorArray[i] = sensor;
-            return true;
-        }
+    if (sensor == nullptr || sensor->GetType() >= SENSOR_TYPE_QTT) {
+        printf("State: sensor with invalid type rejected\n");
+        rejected++;
+        return false;
+    }
+
+    sensor_t type = sensor->GetType();
+    if (sensorArray[type] != nullptr && sensorArray[type] != sensor) {
+        printf("State: sensor type %d already registered\n", type);
+        rejected++;
+        return false;
     }
-    return false;
+    sensorArray[type] = sensor;
+    return true;
 }
 
 Sensor* State::GetSensor(sensor_t type) {
-    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
-        if (sensorArray[i] != nullptr && sensorArray[i]->GetType() == type) {
-            return sensorArray[i];
-        }
+    if (type >= SENSOR_TYPE_QTT) {
+        return nullptr;
     }
-    return nullptr;
+    return sensorArray[type];
 }
 
 bool State::AddAnalyzer(Analyzer* analyzer) {
+    if (analyzer == nullptr || analyzer->GetSensorType() >= SENSOR_TYPE_QTT || analyzer->GetSampleType() >= SAMPLE_TYPE_QTT) {
+        printf("State: analyzer with invalid sensor or sample type rejected\n");
+        rejected++;
+        return false;
+    }
 
-    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
-        if (analyzerArray[i] == nullptr) {
-            analyzerArray[i] = analyzer;
-            return true;
-        }
+    sensor_t type = analyzer->GetSensorType();
+    sample_t sampleType = analyzer->GetSampleType();
+    uint8_t& count = analyzerCount[type][sampleType];
+    if (count >= STATE_MAX_ANALYZERS_PER_SAMPLE) {
+        printf("State: more than %d analyzers for sensor %d sample %d, rejected\n",
+               STATE_MAX_ANALYZERS_PER_SAMPLE, type, sampleType);
+        rejected++;
+        return false;
     }
-    return false;
+    analyzerTable[type][sampleType][count++] = analyzer;
+    return true;
 }
 
+// First analyzer of the pair, nullptr if none
 Analyzer* State::GetAnalyzer(sensor_t type, sample_t sampleType) {
+    if (type >= SENSOR_TYPE_QTT || sampleType >= SAMPLE_TYPE_QTT) {
+        return nullptr;
+    }
+    return analyzerTable[type][sampleType][0];
+}
+
+size_t State::GetAnalyzers(sensor_t type, sample_t sampleType, Analyzer* const** analyzers) {
+    if (type >= SENSOR_TYPE_QTT || sampleType >= SAMPLE_TYPE_QTT) {
+        return 0;
+    }
+    *analyzers = analyzerTable[type][sampleType];
+    return analyzerCount[type][sampleType];
+}
+
+// Startup check: nothing was refused and every analyzer has a sensor to feed it
+bool State::Validate() {
+    bool valid = rejected == 0;
+    if (!valid) {
+        printf("State: %u registrations were rejected\n", (unsigned)rejected);
+    }
 
     for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
-        if (analyzerArray[i] != nullptr && analyzerArray[i]->GetSensorType() == type && analyzerArray[i]->GetSampleType() == sampleType) {
-            return analyzerArray[i];
+        for (size_t j = 0; j < SAMPLE_TYPE_QTT; j++) {
+            if (analyzerCount[i][j] > 0 && sensorArray[i] == nullptr) {
+                printf("State: analyzer for sample %u has no sensor of type %u\n", (unsigned)j, (unsigned)i);
+                valid = false;
+            }
         }
     }
-    return nullptr;
+    return valid;
 }
 
 State::~State() {
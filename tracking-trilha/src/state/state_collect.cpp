@@ -1,7 +1,12 @@
 #include "state_collect.h"
 #include "oximeter.h"
 #include "accelerometer.h"
+#include <stdlib.h>
 
+static_assert(OLED_TASK_PRIORITY < STATE_TASK_PRIORITY && OLED_TASK_PRIORITY < STATE_ANALYSIS_TASK_PRIORITY,
+              "The display task must run below the state tasks");
+static_assert(STATE_TASK_PRIORITY < OXIMETER_DSP_TASK_PRIORITY && OXIMETER_DSP_TASK_PRIORITY < OXIMETER_IO_TASK_PRIORITY &&
+              OXIMETER_IO_TASK_PRIORITY < I2C_BUS_TASK_PRIORITY, "Task priorities must rise towards the bus");
 
 // insert here all wanted_samples
 sample_t StateCollect::wanted_samples[] = {
@@ -10,7 +15,13 @@ sample_t StateCollect::wanted_samples[] = {
     SAMPLE_TYPE_TEMPERATURE,
     SAMPLE_TYPE_ACCEL_X,
     SAMPLE_TYPE_ACCEL_Y,
-    SAMPLE_TYPE_ACCEL_Z
+    SAMPLE_TYPE_ACCEL_Z,
+    SAMPLE_TYPE_GYRO_X,
+    SAMPLE_TYPE_GYRO_Y,
+    SAMPLE_TYPE_GYRO_Z,
+    SAMPLE_TYPE_IMU_TEMP,
+    SAMPLE_TYPE_STEPS,
+    SAMPLE_TYPE_CADENCE
 };
 
 Oled* StateCollect::oled = nullptr;
@@ -18,7 +29,20 @@ Oled* StateCollect::oled = nullptr;
 StateCollect::StateCollect() : State() {
    // Initialize FreeRTOS components
    taskHandle = nullptr;
+   analysisTaskHandle = nullptr;
    taskRunning = false;
+   periodMs = STATE_UPDATE_PERIOD_MS;
+   sensorSet = nullptr;
+   for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+       sensorReady[i] = nullptr;
+   }
+   reportsReady = nullptr;
+   for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+       subscriptionFirst[i] = 0;
+       subscriptionCount[i] = 0;
+   }
+   subscriptionTotal = 0;
+   subscribed = false;
 }
 
 StateCollect::~StateCollect() {
@@ -33,13 +57,20 @@ void StateCollect::PrintOled(int line_index, const char* text) {
 
 void StateCollect::Update() {
     // This method is now deprecated - use StartTask() instead
-    // For backward compatibility, call UpdateInternal directly
+    // For backward compatibility, run both halves directly
+    BuildSubscriptions();
+    AnalyzeInternal();
     UpdateInternal();
 }
 
+// CORE_IO: bus sensors, USB and OLED
 void StateCollect::UpdateInternal() {
-    PrintOled(0, "Coletando...     ");
+    PollSensors();
+    ShowReports();
+}
 
+// Sensors without their own task are read here; they publish what they got
+void StateCollect::PollSensors() {
     for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
         if (sensorArray[i] != nullptr) {
             // Skip oximeter update as it runs in its own task
@@ -49,40 +80,183 @@ void StateCollect::UpdateInternal() {
         }
     }
 
-    // Print wanted_samples
-    for (size_t sensor_type = 0; sensor_type < SENSOR_TYPE_QTT; sensor_type++) {
-        Sensor* sensor = GetSensor((sensor_t)sensor_type);
-        if (sensor != nullptr) {
-            Data_t data;
-            for (size_t sample_index = 0; sample_index < SAMPLE_TYPE_QTT; sample_index++) {
-              Analyzer* analyzer = GetAnalyzer((sensor_t)sensor_type, StateCollect::wanted_samples[sample_index]);
-              data.type = StateCollect::wanted_samples[sample_index];
-              if (sensor->getData(&data)) {
-                  char data_str[17];
-                  sprintf(data_str, "S%2d T%2d V%2.1f", sensor_type, data.type, data.data[0]);
-                  PrintOled(sample_index + 1, data_str);
-                  printf("Sensor Type: %d, Sample Type: %d, Data: ", sensor_type, data.type);
-                  for (size_t buffer_index = 0; buffer_index < data.size; buffer_index++) {
-                      printf("%.3f ", data.data[buffer_index]);
-                  }
-                  if (analyzer != nullptr) {
-                      healthStatus_t healthStatus = analyzer->Analyze(&data);
-                      char health_status_str[17];
-                      sprintf(health_status_str, "H%2d", healthStatus);
-                      PrintOled(7, health_status_str);
-                      printf("Health Status: %d\n", healthStatus);
-                  } else {
-                    printf("No analyzer found for sensor type: %d\n", sensor_type);
-                  }
-                  printf("\n");
-              }
-          }
+    RunGovernor();
+}
+
+bool StateCollect::HasPolledSensors() {
+    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+        if (sensorArray[i] != nullptr && i != SENSOR_TYPE_OXIMETER) {
+            return true;
         }
     }
+    return false;
+}
 
-    if (oled != nullptr) {
+// Print what AnalysisTask produced since the last pass; the OLED is only redrawn when something changed
+bool StateCollect::ShowReports() {
+    stateReport_t report;
+    bool shown = false;
+    while (reports.Pop(&report)) {
+        if (!shown) {
+            PrintOled(0, "Coletando...     ");
+            shown = true;
+        }
+        PrintReport(&report);
+    }
+
+    if (shown && oled != nullptr) {
         oled->Render();
     }
+    return shown;
+}
+
+// Feeds the governor with the accelerometer activity and the oximeter HR stability
+void StateCollect::RunGovernor() {
+    Accelerometer* accelerometer = static_cast<Accelerometer*>(GetSensor(SENSOR_TYPE_ACCELEROMETER));
+    Oximeter* oximeter = static_cast<Oximeter*>(GetSensor(SENSOR_TYPE_OXIMETER));
+    if (accelerometer == nullptr) {
+        return;
+    }
+
+    float heartRateDelta = (oximeter != nullptr) ? oximeter->HeartRateDelta() : 0.0f;
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if (!governor.Update(now, accelerometer->Cadence(), accelerometer->MotionIntensity(), heartRateDelta)) {
+        return;
+    }
+
+    const activityProfile_t* profile = governor.Profile();
+    if (oximeter != nullptr) {
+        oximeter->SetProfile(&profile->oximeter);
+    }
+    uint32_t period = profile->statePeriodMs;
+    periodMs.store(period < STATE_MAX_UPDATE_PERIOD_MS ? period : STATE_MAX_UPDATE_PERIOD_MS, std::memory_order_relaxed);
+}
+
+void StateCollect::PrintReport(const stateReport_t* report) {
+    if (report->overwritten) {
+        printf("Snapshot overwritten, discarding\n");
+        return;
+    }
+
+    char data_str[17];
+    sprintf(data_str, "S%2d T%2d V%2.1f", report->sensorType, report->sampleType, report->first);
+    printf("Sensor Type: %d, Sample Type: %d, Data: %.3f .. %.3f (%u samples) ",
+           report->sensorType, report->sampleType, report->first, report->last, (unsigned)report->size);
+
+    // Line 0 is the status and line 7 the health; later samples only go to the console
+    if (report->sampleIndex < STATE_OLED_SAMPLE_LINES) {
+        PrintOled(report->sampleIndex + 1, data_str);
+    }
+    if (report->analyzed) {
+        char health_status_str[17];
+        sprintf(health_status_str, "H%2d", report->healthStatus);
+        PrintOled(7, health_status_str);
+        printf("Health Status: %d\n", report->healthStatus);
+    } else {
+      printf("No analyzer found for sensor type: %d\n", report->sensorType);
+    }
+    printf("\n");
+}
+
+// CORE_DSP: snapshots and analyzers, no bus access
+void StateCollect::AnalyzeInternal() {
+    for (size_t sensor_type = 0; sensor_type < SENSOR_TYPE_QTT; sensor_type++) {
+        AnalyzeSensor((sensor_t)sensor_type);
+    }
+}
+
+void StateCollect::AnalyzeSensor(sensor_t sensor_type) {
+    Sensor* sensor = GetSensor(sensor_type);
+    if (sensor == nullptr) {
+        return;
+    }
+
+    // Only the pairs the sensor declared and the state wants; no lookups left in the loop
+    Data_t data;
+    const stateSubscription_t* subscription = &subscriptions[subscriptionFirst[sensor_type]];
+    for (size_t n = 0; n < subscriptionCount[sensor_type]; n++, subscription++) {
+        data.type = subscription->sampleType;
+        if (sensor->getData(&data)) {
+            stateReport_t report;
+            report.sensorType = sensor_type;
+            report.sampleType = data.type;
+            report.sampleIndex = subscription->sampleIndex;
+            report.first = data.data[0];
+            report.last = data.data[data.size - 1];
+            report.size = data.size;
+            report.healthStatus = HEALTH_STATUS_NORMAL;
+            report.analyzed = subscription->analyzerCount > 0;
+            // Every analyzer sees the snapshot; the report keeps the status furthest from normal
+            for (size_t k = 0; k < subscription->analyzerCount; k++) {
+                healthStatus_t status = subscription->analyzers[k]->Analyze(&data);
+                if (abs((int)status - HEALTH_STATUS_NORMAL) > abs((int)report.healthStatus - HEALTH_STATUS_NORMAL)) {
+                    report.healthStatus = status;
+                }
+            }
+
+            // The snapshot is only trusted if the producer did not overwrite it meanwhile;
+            // a torn one leaves every analyzer as it was
+            report.overwritten = !sensor->releaseData(&data);
+            if (!report.overwritten) {
+                for (size_t k = 0; k < subscription->analyzerCount; k++) {
+                    subscription->analyzers[k]->Commit();
+                }
+            }
+            reports.Push(report);
+        }
+    }
+}
+
+// Crosses what each sensor declares with wanted_samples, in sensor order so every
+// sensor owns one contiguous run of the table. Analyzers on a sample no sensor
+// produces are reported here, since they would never be called.
+void StateCollect::BuildSubscriptions() {
+    if (subscribed) {
+        return;
+    }
+
+    bool fed[SENSOR_TYPE_QTT][SAMPLE_TYPE_QTT] = {};
+    subscriptionTotal = 0;
+    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+        subscriptionFirst[i] = (uint8_t)subscriptionTotal;
+        subscriptionCount[i] = 0;
+        if (sensorArray[i] == nullptr) {
+            continue;
+        }
+
+        const sample_t* types;
+        size_t type_count = sensorArray[i]->GetSampleTypes(&types);
+        for (size_t sample_index = 0; sample_index < SAMPLE_TYPE_QTT; sample_index++) {
+            sample_t wanted = StateCollect::wanted_samples[sample_index];
+            bool produced = false;
+            for (size_t t = 0; t < type_count; t++) {
+                produced = produced || types[t] == wanted;
+            }
+            if (!produced) {
+                continue;
+            }
+            if (subscriptionTotal >= SAMPLE_TYPE_QTT) {
+                printf("State: subscription table full, sensor %u sample %u dropped\n", (unsigned)i, (unsigned)wanted);
+                continue;
+            }
+
+            stateSubscription_t* subscription = &subscriptions[subscriptionTotal++];
+            subscription->sampleType = wanted;
+            subscription->sampleIndex = (uint8_t)sample_index;
+            subscription->analyzerCount = (uint8_t)GetAnalyzers((sensor_t)i, wanted, &subscription->analyzers);
+            subscriptionCount[i]++;
+            fed[i][wanted] = true;
+        }
+    }
+
+    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+        for (size_t j = 0; j < SAMPLE_TYPE_QTT; j++) {
+            if (analyzerCount[i][j] > 0 && sensorArray[i] != nullptr && !fed[i][j]) {
+                printf("State: sensor %u never produces sample %u, its analyzer is unused\n", (unsigned)i, (unsigned)j);
+            }
+        }
+    }
+    subscribed = true;
 }
 
 void StateCollect::Pause() {
@@ -93,31 +267,80 @@ void StateCollect::Resume() {
     // Resume implementation
 }
 
+// One binary semaphore per registered sensor, all in one queue set. Created once the
+// sensors are registered; a semaphore already given stays given, so a burst of
+// publishes costs AnalysisTask a single wake-up.
+bool StateCollect::CreateEvents() {
+    if (sensorSet != nullptr) {
+        return true;
+    }
+
+    reportsReady = xSemaphoreCreateBinary();
+    sensorSet = xQueueCreateSet(SENSOR_TYPE_QTT);
+    if (reportsReady == nullptr || sensorSet == nullptr) {
+        printf("Failed to create State events\n");
+        return false;
+    }
+
+    for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+        if (sensorArray[i] == nullptr) {
+            continue;
+        }
+        sensorReady[i] = xSemaphoreCreateBinary();
+        if (sensorReady[i] == nullptr || xQueueAddToSet(sensorReady[i], sensorSet) != pdPASS) {
+            printf("Failed to subscribe to sensor %u\n", (unsigned)i);
+            return false;
+        }
+        sensorArray[i]->SetNotify(sensorReady[i]);
+    }
+    return true;
+}
+
 void StateCollect::StartTask() {
     if (taskHandle == nullptr) {
+        BuildSubscriptions();
+        if (!CreateEvents()) {
+            return;
+        }
         taskRunning = true;
         BaseType_t result = xTaskCreate(
-            StateTask,
-            "StateTask",
-            STATE_TASK_STACK_SIZE,
+            AnalysisTask,
+            "AnalysisTask",
+            STATE_ANALYSIS_TASK_STACK_SIZE,
             this,
-            STATE_TASK_PRIORITY,
-            &taskHandle
+            STATE_ANALYSIS_TASK_PRIORITY,
+            &analysisTaskHandle
         );
+
+        if (result == pdPASS) {
+            PinTaskToCore(analysisTaskHandle, CORE_DSP);
+            result = xTaskCreate(
+                StateTask,
+                "StateTask",
+                STATE_TASK_STACK_SIZE,
+                this,
+                STATE_TASK_PRIORITY,
+                &taskHandle
+            );
+        }
         
         if (result != pdPASS) {
             printf("Failed to create State task\n");
-            taskRunning = false;
-            taskHandle = nullptr;
+            StopTask();
         } else {
+            PinTaskToCore(taskHandle, CORE_IO);
             printf("State task created successfully\n");
         }
     }
 }
 
 void StateCollect::StopTask() {
+    taskRunning = false;
+    if (analysisTaskHandle != nullptr) {
+        vTaskDelete(analysisTaskHandle);
+        analysisTaskHandle = nullptr;
+    }
     if (taskHandle != nullptr) {
-        taskRunning = false;
         vTaskDelete(taskHandle);
         taskHandle = nullptr;
         printf("State task stopped\n");
@@ -126,17 +349,55 @@ void StateCollect::StopTask() {
 
 void StateCollect::StateTask(void* pvParameters) {
     StateCollect* stateCollect = static_cast<StateCollect*>(pvParameters);
-    TickType_t xLastWakeTime = xTaskGetTickCount();
+    bool polling = stateCollect->HasPolledSensors();
+    TickType_t nextPoll = xTaskGetTickCount();
     
     printf("State task started\n");
     
     while (stateCollect->taskRunning) {
-        stateCollect->UpdateInternal();
-        
-        // Wait for the next period
-        vTaskDelayUntil(&xLastWakeTime, pdMS_TO_TICKS(STATE_UPDATE_PERIOD_MS));
+        TickType_t wait = portMAX_DELAY;
+        if (polling) {
+            TickType_t now = xTaskGetTickCount();
+            if ((int32_t)(now - nextPoll) >= 0) {
+                stateCollect->PollSensors();
+                nextPoll += pdMS_TO_TICKS(stateCollect->periodMs.load(std::memory_order_relaxed));
+                if ((int32_t)(now - nextPoll) >= 0) {
+                    nextPoll = now + 1;  // fell behind, do not burst to catch up
+                }
+            }
+            wait = nextPoll - xTaskGetTickCount();
+            if ((int32_t)wait < 0) {
+                wait = 0;
+            }
+        }
+
+        // Sleep until AnalysisTask has reports or the next poll is due
+        if (xSemaphoreTake(stateCollect->reportsReady, wait) == pdTRUE) {
+            stateCollect->ShowReports();
+        }
     }
     
     printf("State task ending\n");
     vTaskDelete(nullptr);
 }
+
+void StateCollect::AnalysisTask(void* pvParameters) {
+    StateCollect* stateCollect = static_cast<StateCollect*>(pvParameters);
+
+    // Wakes only when a sensor published, and analyzes only that sensor
+    while (stateCollect->taskRunning) {
+        QueueSetMemberHandle_t member = xQueueSelectFromSet(stateCollect->sensorSet, portMAX_DELAY);
+        for (size_t i = 0; i < SENSOR_TYPE_QTT; i++) {
+            if (member != nullptr && member == stateCollect->sensorReady[i]) {
+                xSemaphoreTake(stateCollect->sensorReady[i], 0);
+                stateCollect->AnalyzeSensor((sensor_t)i);
+            }
+        }
+
+        if (!stateCollect->reports.Empty()) {
+            xSemaphoreGive(stateCollect->reportsReady);
+        }
+    }
+
+    vTaskDelete(nullptr);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <mutex>
+#include "i2c_bus.h"
+
+// Devices behind the I2CBus API, for the tests that build real drivers. Links in place of
+// i2c_bus.cpp: every call runs inline on the caller and lands on the device attached at
+// its address, and a transfer to an empty address fails as a NACK would.
+
+struct FakeI2CDevice {
+    // Every transfer starts with the register address, then writes or reads from there
+    virtual void Read(uint8_t reg, uint8_t* dst, size_t length) = 0;
+    virtual void Write(uint8_t reg, const uint8_t* src, size_t length) = 0;
+};
+
+void FakeI2CAttach(uint8_t address, FakeI2CDevice* device);
+
+// Held during every transfer; a test thread that changes a device while tasks use the
+// bus takes it too
+extern std::mutex fakeI2CLock;
@@ -0,0 +1,77 @@
+#include "fake_imu6050.h"
+#include "imu6050.h"
+#include <string.h>
+
+FakeIMU6050 fakeImu6050;
+
+static const int16_t STILL_FRAME[7] = {0, 0, 16384, 0, 0, 0, 0};  // accel X/Y/Z, temperature, gyro X/Y/Z
+
+FakeIMU6050::FakeIMU6050() {
+    memset(regs, 0, sizeof(regs));
+    produced = 0;
+    frameByte = 0;
+    ResetStats();
+    FakeI2CAttach(MPU_ADDR, this);
+}
+
+void FakeIMU6050::ResetStats() {
+    drained = 0;
+    waitSumUs = 0;
+    waitMaxUs = 0;
+}
+
+// Stores every frame sampled up to now; a full FIFO keeps its oldest frames
+void FakeIMU6050::Fill(std::chrono::steady_clock::time_point now) {
+    if (!(regs[MPU_USER_CTRL] & MPU_USER_CTRL_FIFO_EN) || regs[MPU_FIFO_EN] != MPU_FIFO_EN_ALL) {
+        return;
+    }
+    std::chrono::microseconds period(1000000 * (regs[MPU_SMPLRT_DIV] + 1) / IMU6050_GYRO_RATE_HZ);
+    uint64_t due = (uint64_t)((now - start) / period);
+    for (; produced < due; produced++) {
+        if (frames.size() < IMU6050_FIFO_MAX_FRAMES) {
+            frames.push_back(start + period * (produced + 1));
+        }
+    }
+}
+
+void FakeIMU6050::Read(uint8_t reg, uint8_t* dst, size_t length) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    Fill(now);
+
+    if (reg == MPU_FIFO_COUNTH) {
+        size_t count = frames.size() * IMU6050_FRAME_BYTES - frameByte;
+        dst[0] = (uint8_t)(count >> 8);
+        if (length > 1) dst[1] = (uint8_t)count;
+        return;
+    }
+    if (reg != MPU_FIFO_R_W) {
+        memcpy(dst, &regs[reg], length);
+        return;
+    }
+
+    for (size_t i = 0; i < length && !frames.empty(); i++) {
+        int16_t word = STILL_FRAME[frameByte / 2];
+        dst[i] = (frameByte & 1) ? (uint8_t)word : (uint8_t)(word >> 8);
+        if (++frameByte == IMU6050_FRAME_BYTES) {
+            uint64_t waitUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - frames.front()).count();
+            waitSumUs += waitUs;
+            waitMaxUs = waitUs > waitMaxUs ? waitUs : waitMaxUs;
+            drained++;
+            frames.pop_front();
+            frameByte = 0;
+        }
+    }
+}
+
+void FakeIMU6050::Write(uint8_t reg, const uint8_t* src, size_t length) {
+    for (size_t i = 0; i < length; i++, reg++) {
+        regs[reg & 0x7F] = src[i];
+        if (reg == MPU_USER_CTRL && (src[i] & MPU_USER_CTRL_FIFO_RESET)) {
+            regs[reg] &= ~MPU_USER_CTRL_FIFO_RESET;
+            frames.clear();
+            frameByte = 0;
+            start = std::chrono::steady_clock::now();
+            produced = 0;
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <deque>
+#include "fake_i2c_bus.h"
+
+// An IMU6050 on the fake I2C bus, lying still: once its FIFO is enabled it stores one
+// 14-byte frame (1 g on Z) every 1 / ODR in real time, the ODR coming from SMPLRT_DIV.
+// Every drained frame records how long it waited in the FIFO, which is what a polled
+// sensor costs in latency.
+
+struct FakeIMU6050 : FakeI2CDevice {
+    FakeIMU6050();  // attached at MPU_ADDR
+
+    uint32_t drained;       // frames read out of the FIFO
+    uint64_t waitSumUs;     // their time in the FIFO
+    uint64_t waitMaxUs;
+    void ResetStats();      // under fakeI2CLock when tasks are running
+
+    void Read(uint8_t reg, uint8_t* dst, size_t length) override;
+    void Write(uint8_t reg, const uint8_t* src, size_t length) override;
+
+  private:
+    void Fill(std::chrono::steady_clock::time_point now);
+
+    uint8_t regs[128];
+    std::chrono::steady_clock::time_point start;  // FIFO enabled or reset
+    uint64_t produced;                            // frames since start
+    std::deque<std::chrono::steady_clock::time_point> frames;  // when each stored frame was sampled
+    size_t frameByte;                             // bytes of the oldest frame already read
+};
+
+extern FakeIMU6050 fakeImu6050;
@@ -0,0 +1,154 @@
+#include "fake_max3010x.h"
+#include "MAX3010X.h"
+#include <string.h>
+
+static const uint8_t REG_INTSTAT1 = 0x00;
+static const uint8_t REG_INTSTAT2 = 0x01;
+static const uint8_t REG_INTENABLE1 = 0x02;
+static const uint8_t REG_INTENABLE2 = 0x03;
+static const uint8_t REG_FIFOWRITEPTR = 0x04;
+static const uint8_t REG_FIFOOVERFLOW = 0x05;
+static const uint8_t REG_FIFOREADPTR = 0x06;
+static const uint8_t REG_FIFODATA = 0x07;
+static const uint8_t REG_FIFOCONFIG = 0x08;
+static const uint8_t REG_MODECONFIG = 0x09;
+static const uint8_t REG_DIETEMPINT = 0x1F;
+static const uint8_t REG_DIETEMPFRAC = 0x20;
+static const uint8_t REG_DIETEMPCONFIG = 0x21;
+static const uint8_t REG_PARTID = 0xFF;
+static const uint8_t RESET = 0x40;
+static const uint8_t INT_A_FULL = 0x80;
+static const uint8_t INT_DIE_TEMP_RDY = 0x02;
+static const uint8_t ROLLOVER = 0x10;
+
+FakeMAX3010X fakeMax3010x;
+
+FakeMAX3010X::FakeMAX3010X() {
+    Reset();
+    FakeI2CAttach(MAX3010X_ADDRESS, this);
+}
+
+void FakeMAX3010X::Reset() {
+    memset(regs, 0, sizeof(regs));
+    memset(fifo, 0, sizeof(fifo));
+    regs[REG_PARTID] = 0x15;
+    stored = 0;
+    fifoByte = 0;
+    lost = 0;
+    reads = 0;
+    writes = 0;
+    lastReadLength = 0;
+    lastReadRegister = 0;
+}
+
+uint8_t FakeMAX3010X::ActiveLEDs() const {
+    switch (regs[REG_MODECONFIG] & 0x07) {
+    case 0x07: return 3;
+    case 0x03: return 2;
+    default: return 1;
+    }
+}
+
+void FakeMAX3010X::Push(uint32_t red, uint32_t ir, uint32_t green) {
+    if (stored == FAKE_MAX3010X_FIFO_DEPTH && !(regs[REG_FIFOCONFIG] & ROLLOVER)) {
+        lost++;  // a full FIFO without rollover keeps its samples
+        return;
+    }
+
+    uint32_t words[3] = {red, ir, green};
+    uint8_t* slot = fifo[regs[REG_FIFOWRITEPTR]];
+    for (int i = 0; i < 3; i++) {
+        slot[3 * i] = 0xFC | ((words[i] >> 16) & 0x03);
+        slot[3 * i + 1] = (uint8_t)(words[i] >> 8);
+        slot[3 * i + 2] = (uint8_t)words[i];
+    }
+
+    regs[REG_FIFOWRITEPTR] = (regs[REG_FIFOWRITEPTR] + 1) & (FAKE_MAX3010X_FIFO_DEPTH - 1);
+    if (stored == FAKE_MAX3010X_FIFO_DEPTH) {
+        // Rollover: a full FIFO drops its oldest sample and counts the loss
+        regs[REG_FIFOREADPTR] = regs[REG_FIFOWRITEPTR];
+        fifoByte = 0;
+        if (regs[REG_FIFOOVERFLOW] < 0x1F) regs[REG_FIFOOVERFLOW]++;
+        lost++;
+    } else {
+        stored++;
+    }
+
+    // A_FULL is set as the FIFO reaches 32 - FIFO_A_FULL samples, FIFO_A_FULL being free slots
+    if (stored == FAKE_MAX3010X_FIFO_DEPTH - (regs[REG_FIFOCONFIG] & 0x0F)) {
+        regs[REG_INTSTAT1] |= INT_A_FULL;
+    }
+}
+
+void FakeMAX3010X::SetPointers(uint8_t writePointer, uint8_t readPointer) {
+    regs[REG_FIFOWRITEPTR] = writePointer;
+    regs[REG_FIFOREADPTR] = readPointer;
+    regs[REG_FIFOOVERFLOW] = 0;
+    stored = (writePointer - readPointer) & (FAKE_MAX3010X_FIFO_DEPTH - 1);
+    fifoByte = 0;
+}
+
+bool FakeMAX3010X::IntAsserted() const {
+    return (regs[REG_INTSTAT1] & regs[REG_INTENABLE1]) || (regs[REG_INTSTAT2] & regs[REG_INTENABLE2]);
+}
+
+uint8_t FakeMAX3010X::ReadByte(uint8_t reg) {
+    if (reg == REG_INTSTAT1 || reg == REG_INTSTAT2) {
+        uint8_t status = regs[reg];  // reading the status clears it and releases INT
+        regs[reg] = 0;
+        return status;
+    }
+    if (reg != REG_FIFODATA) {
+        return regs[reg];
+    }
+    regs[REG_INTSTAT1] &= ~INT_A_FULL;  // so does reading the FIFO
+    if (stored == 0) {
+        return 0;
+    }
+
+    uint8_t byte = fifo[regs[REG_FIFOREADPTR]][fifoByte++];
+    if (fifoByte == (size_t)ActiveLEDs() * 3) {
+        fifoByte = 0;
+        regs[REG_FIFOREADPTR] = (regs[REG_FIFOREADPTR] + 1) & (FAKE_MAX3010X_FIFO_DEPTH - 1);
+        regs[REG_FIFOOVERFLOW] = 0;
+        stored--;
+    }
+    return byte;
+}
+
+void FakeMAX3010X::Read(uint8_t reg, uint8_t* dst, size_t length) {
+    reads++;
+    lastReadRegister = reg;
+    lastReadLength = length;
+
+    // Register reads auto-increment, except FIFO_DATA which pops the FIFO instead
+    for (size_t i = 0; i < length; i++) {
+        dst[i] = ReadByte(reg);
+        if (reg != REG_FIFODATA) reg++;
+    }
+}
+
+void FakeMAX3010X::Write(uint8_t reg, const uint8_t* src, size_t length) {
+    writes++;
+    for (size_t i = 0; i < length; i++, reg++) {
+        uint8_t value = src[i];
+        regs[reg] = value;
+        if (reg == REG_MODECONFIG && (value & RESET)) {
+            // Power-on reset, done by the next read
+            memset(regs, 0, sizeof(regs));
+            regs[REG_PARTID] = 0x15;
+            stored = 0;
+            fifoByte = 0;
+        }
+        if (reg >= REG_FIFOWRITEPTR && reg <= REG_FIFOREADPTR) {
+            SetPointers(regs[REG_FIFOWRITEPTR], regs[REG_FIFOREADPTR]);
+        }
+        if (reg == REG_DIETEMPCONFIG && (value & 0x01)) {
+            // Conversion done at once: 31.5 degrees
+            regs[REG_DIETEMPCONFIG] = 0;
+            regs[REG_DIETEMPINT] = 31;
+            regs[REG_DIETEMPFRAC] = 8;
+            regs[REG_INTSTAT2] |= INT_DIE_TEMP_RDY;
+        }
+    }
+}
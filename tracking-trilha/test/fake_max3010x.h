@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "fake_i2c_bus.h"
+
+// A MAX3010X on the fake I2C bus, for the tests that build the real MAX3010X driver: one
+// register file with a 32-sample FIFO that behaves as the datasheet describes
+// (auto-incrementing register reads, FIFO_DATA reads pop samples, pointers wrap at 32,
+// rollover counts lost samples), the A_FULL interrupt with its 4-bit free-slot count and
+// a die temperature that is ready at once.
+
+#define FAKE_MAX3010X_FIFO_DEPTH 32
+
+struct FakeMAX3010X : FakeI2CDevice {
+    uint8_t regs[256];
+    uint8_t fifo[FAKE_MAX3010X_FIFO_DEPTH][9];  // one sample, up to 3 LEDs x 3 bytes
+    uint8_t stored;                             // samples in the FIFO, 32 when full
+    size_t fifoByte;                            // bytes of the sample at the read pointer already sent
+
+    uint32_t lost;                              // samples dropped or overwritten by a full FIFO
+    uint32_t reads;                             // read transfers
+    uint32_t writes;                            // write transfers
+    size_t lastReadLength;
+    uint8_t lastReadRegister;
+
+    FakeMAX3010X();  // attached at MAX3010X_ADDRESS
+
+    void Reset();
+    uint8_t ActiveLEDs() const;                 // from the LED mode in MODE_CONFIG
+    // Pushes one sample as the ADC would. The unused top bits of every word are set so a
+    // reader that forgets the 18-bit mask sees garbage.
+    void Push(uint32_t red, uint32_t ir, uint32_t green);
+    void SetPointers(uint8_t writePointer, uint8_t readPointer);
+    bool IntAsserted() const;                   // INT is low: an enabled interrupt status is set
+
+    void Read(uint8_t reg, uint8_t* dst, size_t length) override;
+    void Write(uint8_t reg, const uint8_t* src, size_t length) override;
+
+  private:
+    uint8_t ReadByte(uint8_t reg);
+};
+
+extern FakeMAX3010X fakeMax3010x;
@@ -0,0 +1,29 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS types and macros the tested headers use. Tests that
+// only need the types define the few calls they make themselves; tests that run real
+// tasks link freertos_host.cpp, which maps tasks to threads.
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void* QueueHandle_t;
+typedef void* SemaphoreHandle_t;
+typedef void* QueueSetHandle_t;
+typedef void* QueueSetMemberHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(x) ((TickType_t)(x))
+#define portYIELD_FROM_ISR(x) (void)(x)
+#define tskIDLE_PRIORITY 0
+#define configNUMBER_OF_CORES 1
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 2
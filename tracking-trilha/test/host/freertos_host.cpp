@@ -0,0 +1,306 @@
+// Host port of the FreeRTOS calls the firmware makes: every task is a thread, all of them
+// run at once as on the SMP build, and priorities and core affinity are ignored. Blocking
+// calls wait on one condition variable with real-time timeouts (one tick is 1 ms). The
+// main thread stands for the code that runs before the scheduler starts.
+//
+// vTaskDelete() on another task takes effect at that task's next blocking call, which
+// unwinds it. Task objects are never freed, so a deleted handle stays safe to look at.
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "freertos_host.h"
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct HostTask {
+    const char* name;
+    TaskFunction_t function;
+    void* parameters;
+    uint32_t notifications[configTASK_NOTIFICATION_ARRAY_ENTRIES];
+    uint32_t wakeups;
+    uint32_t timeouts;
+    bool deleted;
+    std::thread thread;
+};
+
+// Queues, semaphores (zero-size items) and queue sets (items are member handles)
+struct HostQueue {
+    size_t itemSize;
+    size_t length;
+    std::deque<std::vector<uint8_t>> items;
+    HostQueue* set;
+};
+
+struct TaskDeleted {};
+
+std::mutex portLock;
+std::condition_variable portChanged;
+std::vector<HostTask*> tasks;
+std::atomic<uint32_t> delays(0);
+thread_local HostTask* current = nullptr;
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+// Waits until ready() holds or ticks run out, under portLock. Returns ready().
+template <typename F>
+bool Block(std::unique_lock<std::mutex>& guard, TickType_t ticks, F ready) {
+    if (ready()) {
+        return true;
+    }
+    if (ticks == 0) {
+        return false;
+    }
+
+    auto woken = [&] { return ready() || (current != nullptr && current->deleted); };
+    if (ticks == portMAX_DELAY) {
+        portChanged.wait(guard, woken);
+    } else {
+        portChanged.wait_for(guard, std::chrono::milliseconds(ticks), woken);
+    }
+    if (current != nullptr) {
+        if (current->deleted) {
+            throw TaskDeleted();
+        }
+        current->wakeups++;
+        if (!ready()) {
+            current->timeouts++;
+        }
+    }
+    return ready();
+}
+
+void Run(HostTask* task) {
+    current = task;
+    try {
+        task->function(task->parameters);
+    } catch (const TaskDeleted&) {
+    }
+}
+
+// Adds one item and tells the set the queue belongs to, under portLock
+void Append(HostQueue* queue, const void* item) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(item);
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    if (queue->set != nullptr && queue->set->items.size() < queue->set->length) {
+        HostQueue* member = queue;
+        Append(queue->set, &member);
+    }
+    portChanged.notify_all();
+}
+
+HostQueue* CreateQueue(size_t length, size_t itemSize) {
+    HostQueue* queue = new HostQueue();
+    queue->itemSize = itemSize;
+    queue->length = length;
+    queue->set = nullptr;
+    return queue;
+}
+
+uint32_t Count(const char* name, uint32_t HostTask::*counter) {
+    std::lock_guard<std::mutex> guard(portLock);
+    uint32_t total = 0;
+    for (HostTask* task : tasks) {
+        if (strcmp(task->name, name) == 0) {
+            total += task->*counter;
+        }
+    }
+    return total;
+}
+
+}  // namespace
+
+// Tasks
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameters,
+                       UBaseType_t priority, TaskHandle_t* created) {
+    (void)stackDepth;
+    (void)priority;
+    HostTask* task = new HostTask();
+    task->name = name;
+    task->function = function;
+    task->parameters = parameters;
+    task->wakeups = 0;
+    task->timeouts = 0;
+    task->deleted = false;
+    if (created != nullptr) {
+        *created = task;
+    }
+
+    std::lock_guard<std::mutex> guard(portLock);
+    tasks.push_back(task);
+    task->thread = std::thread(Run, task);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t handle) {
+    HostTask* task = handle != nullptr ? static_cast<HostTask*>(handle) : current;
+    {
+        std::lock_guard<std::mutex> guard(portLock);
+        task->deleted = true;
+        portChanged.notify_all();
+    }
+    if (task == current) {
+        throw TaskDeleted();
+    }
+    if (task->thread.joinable()) {
+        task->thread.join();
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return current;
+}
+
+BaseType_t xTaskGetSchedulerState(void) {
+    return current != nullptr ? taskSCHEDULER_RUNNING : taskSCHEDULER_NOT_STARTED;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delays++;
+    std::unique_lock<std::mutex> guard(portLock);
+    Block(guard, ticks, [] { return false; });
+}
+
+// Notifications
+
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clearOnExit, TickType_t ticks) {
+    HostTask* task = current;
+    std::unique_lock<std::mutex> guard(portLock);
+    Block(guard, ticks, [&] { return task->notifications[index] > 0; });
+    uint32_t value = task->notifications[index];
+    if (value > 0) {
+        task->notifications[index] = clearOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    return ulTaskNotifyTakeIndexed(0, clearOnExit, ticks);
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t handle, UBaseType_t index) {
+    std::lock_guard<std::mutex> guard(portLock);
+    static_cast<HostTask*>(handle)->notifications[index]++;
+    portChanged.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+    return xTaskNotifyGiveIndexed(handle, 0);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t* higherPriorityTaskWoken) {
+    xTaskNotifyGiveIndexed(handle, 0);
+    if (higherPriorityTaskWoken != nullptr) {
+        *higherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+// Queues and queue sets
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    return CreateQueue(length, itemSize);
+}
+
+BaseType_t xQueueSend(QueueHandle_t handle, const void* item, TickType_t ticks) {
+    HostQueue* queue = static_cast<HostQueue*>(handle);
+    std::unique_lock<std::mutex> guard(portLock);
+    if (!Block(guard, ticks, [&] { return queue->items.size() < queue->length; })) {
+        return pdFAIL;
+    }
+    Append(queue, item);
+    return pdPASS;
+}
+
+static BaseType_t Receive(QueueHandle_t handle, void* item, TickType_t ticks, bool remove) {
+    HostQueue* queue = static_cast<HostQueue*>(handle);
+    std::unique_lock<std::mutex> guard(portLock);
+    if (!Block(guard, ticks, [&] { return !queue->items.empty(); })) {
+        return pdFAIL;
+    }
+    if (item != nullptr) {
+        memcpy(item, queue->items.front().data(), queue->itemSize);
+    }
+    if (remove) {
+        queue->items.pop_front();
+        portChanged.notify_all();
+    }
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t ticks) {
+    return Receive(handle, item, ticks, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t handle, void* item, TickType_t ticks) {
+    return Receive(handle, item, ticks, false);
+}
+
+QueueSetHandle_t xQueueCreateSet(UBaseType_t length) {
+    return CreateQueue(length, sizeof(HostQueue*));
+}
+
+BaseType_t xQueueAddToSet(QueueSetMemberHandle_t member, QueueSetHandle_t set) {
+    HostQueue* queue = static_cast<HostQueue*>(member);
+    std::lock_guard<std::mutex> guard(portLock);
+    if (queue->set != nullptr || !queue->items.empty()) {
+        return pdFAIL;
+    }
+    queue->set = static_cast<HostQueue*>(set);
+    return pdPASS;
+}
+
+QueueSetMemberHandle_t xQueueSelectFromSet(QueueSetHandle_t set, TickType_t ticks) {
+    HostQueue* member = nullptr;
+    if (Receive(set, &member, ticks, true) != pdPASS) {
+        return nullptr;
+    }
+    return member;
+}
+
+// Semaphores: queues of zero-size items
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return CreateQueue(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    HostQueue* queue = CreateQueue(1, 0);
+    queue->items.emplace_back();
+    return queue;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return Receive(semaphore, nullptr, ticks, true);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, nullptr, 0);
+}
+
+// Host-only counters
+
+uint32_t HostTaskWakeups(const char* name) {
+    return Count(name, &HostTask::wakeups);
+}
+
+uint32_t HostTaskTimeouts(const char* name) {
+    return Count(name, &HostTask::timeouts);
+}
+
+uint32_t HostTaskDelays(void) {
+    return delays.load();
+}
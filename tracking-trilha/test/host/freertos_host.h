@@ -0,0 +1,11 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// Host-only view into freertos_host.cpp, for the tests that count how often tasks run.
+// A wake-up is a task leaving the Blocked state: a blocking call that had to wait and
+// returned, on its event or on its timeout. Calls that find their event ready do not count.
+
+uint32_t HostTaskWakeups(const char* name);   // summed over every task created with this name
+uint32_t HostTaskTimeouts(const char* name);  // the wake-ups that were timeouts
+uint32_t HostTaskDelays(void);                // vTaskDelay() calls from every task
@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the Pico SDK GPIO API. Tests that build a driver with an interrupt
+// pin define these themselves and raise the interrupt by calling the registered handler.
+
+#include "pico/stdlib.h"
+
+#define GPIO_IN false
+#define GPIO_OUT true
+#define GPIO_IRQ_LEVEL_LOW 0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+
+typedef void (*irq_handler_t)(void);
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler);
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+uint32_t gpio_get_irq_event_mask(uint gpio);
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask);
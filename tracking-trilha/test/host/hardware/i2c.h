@@ -0,0 +1,15 @@
+#pragma once
+
+// Host stand-in for the Pico SDK I2C API. Tests that send data define i2c_write_blocking()
+// themselves to see the bytes.
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t* const i2c0;
+extern i2c_inst_t* const i2c1;
+
+#define NUM_I2CS 2
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop);
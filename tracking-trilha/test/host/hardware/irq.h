@@ -0,0 +1,7 @@
+#pragma once
+
+#include "hardware/gpio.h"
+
+#define IO_IRQ_BANK0 13
+
+void irq_set_enabled(uint num, bool enabled);
@@ -0,0 +1,23 @@
+#pragma once
+
+// Host stand-in for the parts of the Pico SDK the tested modules use
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <assert.h>
+
+typedef unsigned int uint;
+
+typedef uint64_t absolute_time_t;
+absolute_time_t get_absolute_time(void);
+uint32_t to_ms_since_boot(absolute_time_t t);
+void sleep_ms(uint32_t ms);
+void busy_wait_ms(uint32_t ms);
+
+#define _u(x) x ## u
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+enum gpio_function { GPIO_FUNC_I2C = 3 };
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+// Minimal check and timing helpers shared by the host tests
+
+static int host_test_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol) \
+    do { \
+        double host_test_a = (a), host_test_b = (b); \
+        if (!(host_test_a - host_test_b <= (tol) && host_test_b - host_test_a <= (tol))) { \
+            printf("%s:%d: CHECK_NEAR failed: %s = %g, %s = %g, tolerance %g\n", \
+                   __FILE__, __LINE__, #a, host_test_a, #b, host_test_b, (double)(tol)); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+// Exit status for main(): 0 when every check passed
+inline int HostTestResult(const char* name) {
+    if (host_test_failures != 0) {
+        printf("%s: %d check(s) failed\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// Wall-clock nanoseconds of one call of fn, for the benchmark printouts
+template <typename F>
+double TimeNs(F fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Keeps the optimizer from dropping a benchmark result
+static volatile float host_test_sink;
@@ -0,0 +1,200 @@
+#include <math.h>
+#include <random>
+#include "host_test.h"
+#include "activity_governor.h"
+#include "step_counter.h"
+
+// Replays synthetic accelerometer traces through the StepCounter into the ActivityGovernor,
+// on the StateTask tick, and checks when the profile moves. The time spent in each profile
+// is then priced in HR/SpO2 CPU time and LED charge, against staying in RUNNING throughout.
+
+static const float SAMPLE_RATE = 100.0f;  // ACCEL_ODR_HZ
+static const uint32_t TICK_MS = 100;      // fastest profile statePeriodMs
+
+static std::mt19937 generator(2);
+static std::normal_distribution<float> noise(0.0f, 0.01f);
+
+typedef struct {
+    StepCounter counter;
+    ActivityGovernor governor;
+    uint32_t nowMs;
+    uint32_t sample;
+    uint32_t profileMs[ACTIVITY_PROFILE_QTT];  // replayed time per profile
+} replay_t;
+
+// seconds of steps at hz (0 stands still) with the given impact amplitude and HR change per result.
+// Returns the time of the first profile change, 0 when there was none.
+static uint32_t Replay(replay_t* replay, float hz, float amplitude, float seconds, float heartRateDelta) {
+    uint32_t changedMs = 0;
+    uint32_t samples = (uint32_t)(seconds * SAMPLE_RATE);
+    for (uint32_t i = 0; i < samples; i++, replay->sample++) {
+        float cycle = 0.5f + 0.5f * cosf(2.0f * (float)M_PI * hz * replay->sample / SAMPLE_RATE);
+        float impact = amplitude > 0.0f ? 2.0f * amplitude * cycle * cycle - 0.5f * amplitude : 0.0f;
+        replay->counter.Push(noise(generator), noise(generator), 1.0f + impact + noise(generator));
+
+        replay->nowMs = (uint32_t)(replay->sample * 1000 / SAMPLE_RATE);
+        if (replay->nowMs % TICK_MS == 0) {
+            if (replay->nowMs > 0) {
+                replay->profileMs[replay->governor.ProfileId()] += TICK_MS;  // the tick that just ended
+            }
+            bool changed = replay->governor.Update(replay->nowMs, replay->counter.Cadence(),
+                                                   replay->counter.Intensity(), heartRateDelta);
+            if (changed && changedMs == 0) {
+                changedMs = replay->nowMs;
+            }
+        }
+    }
+    return changedMs;
+}
+
+// The decisions alone, on exact inputs
+static void TestThresholds() {
+    ActivityGovernor governor;
+
+    // Down only after GOVERNOR_HOLD_MS of wanting it
+    uint32_t nowMs = 0;
+    for (; nowMs < GOVERNOR_HOLD_MS; nowMs += TICK_MS) {
+        CHECK(!governor.Update(nowMs, 0.0f, 0.0f, 0.0f));
+    }
+    CHECK(governor.Update(nowMs, 0.0f, 0.0f, 0.0f));
+    CHECK(governor.ProfileId() == ACTIVITY_PROFILE_REST);
+
+    // Up on the very tick the input crosses
+    nowMs += TICK_MS;
+    CHECK(governor.Update(nowMs, GOVERNOR_WALK_CADENCE, 0.0f, 0.0f));
+    CHECK(governor.ProfileId() == ACTIVITY_PROFILE_WALKING);
+    nowMs += TICK_MS;
+    CHECK(governor.Update(nowMs, 0.0f, GOVERNOR_RUN_INTENSITY_G, 0.0f));
+    CHECK(governor.ProfileId() == ACTIVITY_PROFILE_RUNNING);
+
+    // Wanting the current profile again restarts the hold
+    nowMs += TICK_MS;
+    CHECK(!governor.Update(nowMs, 0.0f, 0.0f, 0.0f));
+    CHECK(!governor.Update(nowMs + GOVERNOR_HOLD_MS - TICK_MS, GOVERNOR_RUN_CADENCE, 0.0f, 0.0f));
+    CHECK(!governor.Update(nowMs + GOVERNOR_HOLD_MS, 0.0f, 0.0f, 0.0f));
+    CHECK(governor.ProfileId() == ACTIVITY_PROFILE_RUNNING);
+
+    // The HR floor alone lifts REST to WALKING but never higher
+    ActivityGovernor resting;
+    resting.Update(0, 0.0f, 0.0f, 0.0f);
+    resting.Update(GOVERNOR_HOLD_MS, 0.0f, 0.0f, 0.0f);
+    CHECK(resting.ProfileId() == ACTIVITY_PROFILE_REST);
+    CHECK(resting.Update(GOVERNOR_HOLD_MS + TICK_MS, 0.0f, 0.0f, GOVERNOR_HR_UNSTABLE_BPM));
+    CHECK(resting.ProfileId() == ACTIVITY_PROFILE_WALKING);
+    CHECK(!resting.Update(GOVERNOR_HOLD_MS + 2 * TICK_MS, 0.0f, 0.0f, 10 * GOVERNOR_HR_UNSTABLE_BPM));
+}
+
+// Host time of one RFStream::Compute() on a full window, the work behind every HR/SpO2 result
+static double ComputeNs() {
+    static RFStream<OximeterRF> stream;
+    for (int i = 0; i < OximeterRF::BUFFER_SIZE; i++) {
+        float phase = 2.0f * (float)M_PI * 1.25f * i / OximeterRF::FS;
+        stream.Push((uint32_t)(100000 + 900 * sinf(phase)), (uint32_t)(80000 + 500 * sinf(phase + 0.1f)));
+    }
+
+    const int repeats = 20000;
+    float spo2, ratio, correl;
+    int8_t spo2Valid, hrValid;
+    int32_t heartRate;
+    double ns = TimeNs([&] {
+        for (int r = 0; r < repeats; r++) {
+            stream.Compute(&spo2, &spo2Valid, &heartRate, &hrValid, &ratio, &correl);
+            host_test_sink = spo2;
+        }
+    });
+    CHECK(hrValid == 1);
+    return ns / repeats;
+}
+
+// Cost of the replay per profile: RF results per second times the measured Compute() time,
+// StateTask/AnalysisTask wakeups per second, and LED charge as amplitude (mA) times LED
+// pulses per second. Shares are relative to RUNNING, the fixed setup the governor replaced.
+static void ReportCost(const replay_t* replay) {
+    double computeNs = ComputeNs();
+    const activityProfile_t& running = ActivityGovernor::profiles[ACTIVITY_PROFILE_RUNNING];
+    double runningLed = running.oximeter.ledAmplitude * 50.0 / 255.0 * running.oximeter.sampleRate;
+    double runningCpu = (double)OXIMETER_RF_RATE / running.oximeter.hopSamples * computeNs;
+
+    double totalMs = 0, cpu = 0, led = 0;
+    printf("RFStream::Compute() %.0f ns on the host\n", computeNs);
+    for (int id = 0; id < ACTIVITY_PROFILE_QTT; id++) {
+        const activityProfile_t& profile = ActivityGovernor::profiles[id];
+        double resultsPerSecond = (double)OXIMETER_RF_RATE / profile.oximeter.hopSamples;
+        double cpuNsPerSecond = resultsPerSecond * computeNs;
+        double ledMa = profile.oximeter.ledAmplitude * 50.0 / 255.0;
+        double ledPerSecond = ledMa * profile.oximeter.sampleRate;
+        double ms = replay->profileMs[id];
+        printf("%-8s %6.1f s: %4.1f results/s, %7.0f ns/s Compute (%3.0f%%), %4.1f state wakeups/s, LED %5.2f mA x %4u pulses/s (%3.0f%%)\n",
+               profile.name, ms / 1000, resultsPerSecond, cpuNsPerSecond, 100 * cpuNsPerSecond / runningCpu,
+               1000.0 / profile.statePeriodMs, ledMa, profile.oximeter.sampleRate, 100 * ledPerSecond / runningLed);
+        totalMs += ms;
+        cpu += ms * cpuNsPerSecond;
+        led += ms * ledPerSecond;
+    }
+    cpu /= totalMs;
+    led /= totalMs;
+    printf("replay of %.0f s: %.0f ns/s Compute (%.0f%% of RUNNING), LED charge %.0f%% of RUNNING\n",
+           totalMs / 1000, cpu, 100 * cpu / runningCpu, 100 * led / runningLed);
+
+    CHECK(totalMs == replay->nowMs - replay->nowMs % TICK_MS);
+    CHECK(cpu < runningCpu && led < runningLed);
+}
+
+int main() {
+    TestThresholds();
+
+    replay_t replay = {StepCounter(SAMPLE_RATE), ActivityGovernor(), 0, 0, {}};
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_RUNNING);  // until the sensors have settled
+
+    // Rest: the start-up profile is held for GOVERNOR_HOLD_MS, then drops
+    uint32_t changedMs = Replay(&replay, 0.0f, 0.0f, 60.0f, 1.0f);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_REST);
+    CHECK(changedMs >= GOVERNOR_HOLD_MS);
+    uint32_t transitions = replay.governor.Transitions();
+
+    // Walking at 108 steps/min
+    uint32_t startMs = replay.nowMs;
+    changedMs = Replay(&replay, 1.8f, 0.3f, 60.0f, 1.0f);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_WALKING);
+    printf("rest -> walking after %u ms\n", changedMs - startMs);
+
+    // Running: no hold on the way up, only the time the step counter needs to see it
+    startMs = replay.nowMs;
+    changedMs = Replay(&replay, 2.8f, 0.8f, 30.0f, 1.0f);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_RUNNING);
+    printf("walking -> running after %u ms\n", changedMs - startMs);
+    CHECK(changedMs - startMs < 3000);
+
+    // A 3 s stop at a crossing does not drop the profile
+    CHECK(Replay(&replay, 0.0f, 0.0f, 3.0f, 1.0f) == 0);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_RUNNING);
+    CHECK(Replay(&replay, 2.8f, 0.8f, 10.0f, 1.0f) == 0);
+
+    // A real stop drops straight to REST once it has lasted GOVERNOR_HOLD_MS
+    startMs = replay.nowMs;
+    changedMs = Replay(&replay, 0.0f, 0.0f, 30.0f, 1.0f);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_REST);
+    printf("running -> rest after %u ms\n", changedMs - startMs);
+    CHECK(changedMs - startMs >= GOVERNOR_HOLD_MS);
+    CHECK(changedMs - startMs < GOVERNOR_HOLD_MS + 3000);  // plus the time the filters need to settle
+
+    // Standing still with an unsettled heart rate: WALKING is the floor
+    changedMs = Replay(&replay, 0.0f, 0.0f, 10.0f, GOVERNOR_HR_UNSTABLE_BPM + 1.0f);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_WALKING);
+    CHECK(changedMs != 0);
+    CHECK(Replay(&replay, 0.0f, 0.0f, 30.0f, GOVERNOR_HR_UNSTABLE_BPM + 1.0f) == 0);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_WALKING);
+
+    // ... released with the usual hold once it settles
+    startMs = replay.nowMs;
+    changedMs = Replay(&replay, 0.0f, 0.0f, 10.0f, 1.0f);
+    CHECK(replay.governor.ProfileId() == ACTIVITY_PROFILE_REST);
+    CHECK(changedMs - startMs >= GOVERNOR_HOLD_MS);
+
+    printf("%u transitions\n", replay.governor.Transitions());
+    CHECK(replay.governor.Transitions() == transitions + 5);  // no bouncing anywhere
+
+    ReportCost(&replay);
+
+    return HostTestResult("test_activity_governor");
+}
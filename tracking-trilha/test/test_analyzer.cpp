@@ -0,0 +1,160 @@
+#include <random>
+#include <vector>
+#include "host_test.h"
+#include "analyzer.h"
+
+// Status stability and per-sample cost of the streaming Analyzer, against the stateless
+// threshold loop it replaced
+
+// Heart rate analyzer as configured in main.cpp
+static const analyzerConfig_t HEART_RATE_CONFIG = {
+    .thresholds = {0.0f, 60.0f, 100.0f, 140.0f, 180.0f},
+    .sensorType = SENSOR_TYPE_OXIMETER,
+    .sampleType = SAMPLE_TYPE_HEART_RATE,
+    .hysteresis = 3.0f,
+    .dwellSamples = 2,
+    .ewmaAlpha = 0.2f
+};
+
+static const size_t SNAPSHOT_SAMPLES = 64;
+
+// The original Analyzer::Analyze(): status of the last sample, nothing kept between calls
+static healthStatus_t AnalyzeStateless(const analyzerConfig_t& config, const Data_t* data) {
+    healthStatus_t healthStatus = HEALTH_STATUS_NORMAL;
+    for (size_t i = 0; i < data->size; i++) {
+        for (size_t j = 0; j < HEALTH_STATUS_CRITICAL_HIGH + 1; j++) {
+            if (data->data[i] < config.thresholds[j]) {
+                break;
+            }
+            healthStatus = (healthStatus_t)j;
+        }
+    }
+    return healthStatus;
+}
+
+static Data_t Snapshot(const float* samples, size_t size) {
+    Data_t data = {};
+    data.data = samples;
+    data.size = size;
+    data.type = SAMPLE_TYPE_HEART_RATE;
+    return data;
+}
+
+// Status changes over 2000 snapshots of a heart rate sitting on the 100 bpm threshold
+static void CountChanges(float jitter, int* statelessChanges, int* streamingChanges) {
+    std::mt19937 generator(3);
+    std::normal_distribution<float> heartRate(100.0f, jitter);
+    std::vector<float> samples(SNAPSHOT_SAMPLES);
+
+    Analyzer analyzer(HEART_RATE_CONFIG);
+    healthStatus_t statelessLast = HEALTH_STATUS_NORMAL, streamingLast = HEALTH_STATUS_NORMAL;
+    *statelessChanges = *streamingChanges = 0;
+    for (int call = 0; call < 2000; call++) {
+        for (float& x : samples) {
+            x = heartRate(generator);
+        }
+        Data_t data = Snapshot(samples.data(), samples.size());
+
+        healthStatus_t stateless = AnalyzeStateless(HEART_RATE_CONFIG, &data);
+        healthStatus_t streaming = analyzer.Analyze(&data);
+        analyzer.Commit();
+        if (call > 0) {
+            *statelessChanges += stateless != statelessLast;
+            *streamingChanges += streaming != streamingLast;
+        }
+        statelessLast = stateless;
+        streamingLast = streaming;
+    }
+    CHECK_NEAR(analyzer.GetStats().mean, 100.0, 0.1);
+    CHECK(analyzer.GetStats().count == 2000 * SNAPSHOT_SAMPLES);
+}
+
+static void TestFlicker() {
+    int stateless, streaming;
+
+    // Jitter well inside the hysteresis: the old status follows the last sample, the new one holds
+    CountChanges(1.0f, &stateless, &streaming);
+    printf("1 bpm jitter: %d status changes stateless, %d streaming\n", stateless, streaming);
+    CHECK(stateless > 500);
+    CHECK(streaming <= 2);
+
+    // Jitter as wide as the hysteresis: runs of dwellSamples outliers still get through
+    CountChanges(2.0f, &stateless, &streaming);
+    printf("2 bpm jitter: %d status changes stateless, %d streaming\n", stateless, streaming);
+    CHECK(streaming < stateless / 2);
+}
+
+static void TestTransitions() {
+    Analyzer analyzer(HEART_RATE_CONFIG);
+
+    // Status ranges: LOW from 60, NORMAL from 100, HIGH from 140 bpm. A clear change is
+    // reported after exactly dwellSamples samples, across snapshots.
+    const float high[] = {150.0f};
+    Data_t data = Snapshot(high, 1);
+    CHECK(analyzer.Analyze(&data) == HEALTH_STATUS_NORMAL);
+    analyzer.Commit();
+    CHECK(analyzer.Analyze(&data) == HEALTH_STATUS_HIGH);
+    analyzer.Commit();
+
+    // Inside the hysteresis band nothing moves
+    const float edge[] = {138.0f, 138.0f, 138.0f, 138.0f};
+    data = Snapshot(edge, 4);
+    CHECK(analyzer.Analyze(&data) == HEALTH_STATUS_HIGH);
+    analyzer.Commit();
+
+    // Invalid results (-999) are below thresholds[0]: not classified, the status stays
+    const float invalid[] = {-999.0f, -999.0f, -999.0f};
+    data = Snapshot(invalid, 3);
+    CHECK(analyzer.Analyze(&data) == HEALTH_STATUS_HIGH);
+    analyzer.Commit();
+    CHECK(analyzer.GetStatus() == HEALTH_STATUS_HIGH);
+
+    // An analyzed snapshot that is not committed leaves no trace
+    const float low[] = {70.0f, 70.0f, 70.0f};
+    analyzerStats_t before = analyzer.GetStats();
+    data = Snapshot(low, 3);
+    CHECK(analyzer.Analyze(&data) == HEALTH_STATUS_LOW);
+    CHECK(analyzer.GetStatus() == HEALTH_STATUS_HIGH);
+    CHECK(analyzer.GetStats().count == before.count);
+    CHECK(analyzer.GetStats().last == before.last);
+    CHECK(analyzer.Analyze(&data) == HEALTH_STATUS_LOW);
+    analyzer.Commit();
+    CHECK(analyzer.GetStatus() == HEALTH_STATUS_LOW);
+    CHECK(analyzer.GetStats().count == before.count + 3);
+}
+
+static void BenchmarkCost() {
+    std::mt19937 generator(4);
+    std::normal_distribution<float> heartRate(100.0f, 2.0f);
+    std::vector<float> samples(MAX_BUFFER_SIZE);
+    for (float& x : samples) {
+        x = heartRate(generator);
+    }
+    Data_t data = Snapshot(samples.data(), samples.size());
+
+    const int calls = 200000;
+    int sink = 0;
+    double statelessNs = TimeNs([&] {
+        for (int call = 0; call < calls; call++) {
+            sink += AnalyzeStateless(HEART_RATE_CONFIG, &data);
+        }
+    });
+    Analyzer analyzer(HEART_RATE_CONFIG);
+    double streamingNs = TimeNs([&] {
+        for (int call = 0; call < calls; call++) {
+            sink += analyzer.Analyze(&data);
+            analyzer.Commit();
+        }
+    });
+    host_test_sink = (float)sink;
+    printf("stateless %.2f ns/sample, streaming %.2f ns/sample (with statistics)\n",
+           statelessNs / calls / MAX_BUFFER_SIZE, streamingNs / calls / MAX_BUFFER_SIZE);
+}
+
+int main() {
+    TestFlicker();
+    TestTransitions();
+    BenchmarkCost();
+
+    return HostTestResult("test_analyzer");
+}
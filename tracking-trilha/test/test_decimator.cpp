@@ -0,0 +1,116 @@
+#include <math.h>
+#include "host_test.h"
+#include "decimator.h"
+
+// Frequency response of the oximeter decimator: 400 Hz FIFO down to the 25 Hz RF rate
+
+static const double INPUT_RATE = 400.0;
+static const size_t FACTOR = 16;  // OXIMETER_DECIMATION
+static const size_t TAPS = 8;     // OXIMETER_DECIMATOR_TAPS
+static const int INPUT_SAMPLES = 400 * 60;
+static const double OFFSET = 1 << 20;
+static const double AMPLITUDE = 1 << 18;
+
+// Output amplitude over input amplitude for a tone at hz, in dB. Aliased tones come out at
+// another frequency, so the amplitude is taken from the RMS of the output around its mean.
+static double GainDb(double hz) {
+    static uint32_t in[INPUT_SAMPLES];
+    static uint32_t out[INPUT_SAMPLES / FACTOR + 1];
+    for (int i = 0; i < INPUT_SAMPLES; i++) {
+        in[i] = (uint32_t)lround(OFFSET + AMPLITUDE * sin(2 * M_PI * hz * i / INPUT_RATE + 0.3));
+    }
+
+    Decimator<uint32_t, FACTOR, TAPS> decimator;
+    size_t count = decimator.Process(in, INPUT_SAMPLES, out);
+
+    double mean = 0, power = 0;
+    for (size_t m = 0; m < count; m++) {
+        mean += out[m];
+    }
+    mean /= count;
+    for (size_t m = 0; m < count; m++) {
+        power += (out[m] - mean) * (out[m] - mean);
+    }
+    return 20 * log10(sqrt(2 * power / count) / AMPLITUDE);
+}
+
+// Cost per input sample of Process() on the 400 Hz stream, against filtering every input with
+// the full TAPS-long FIR and keeping one output in FACTOR, the direct form the polyphase
+// split avoids
+static void Benchmark() {
+    const int samples = INPUT_SAMPLES;
+    static uint32_t in[INPUT_SAMPLES];
+    static uint32_t out[INPUT_SAMPLES / FACTOR + 1];
+    for (int i = 0; i < samples; i++) {
+        in[i] = (uint32_t)lround(OFFSET + AMPLITUDE * sin(2 * M_PI * 1.3 * i / INPUT_RATE));
+    }
+
+    static Decimator<uint32_t, FACTOR, TAPS> decimator;
+    size_t count = 0;
+    double polyphaseNs = TimeNs([&] {
+        count = decimator.Process(in, samples, out);
+    });
+    host_test_sink = (float)out[count - 1];
+
+    const size_t taps = FACTOR * TAPS;
+    int16_t h[taps];
+    for (size_t j = 0; j < taps; j++) {
+        h[j] = 32768 / taps;
+    }
+    static uint32_t history[taps];
+    size_t directCount = 0;
+    double directNs = TimeNs([&] {
+        size_t head = 0;
+        for (int i = 0; i < samples; i++) {
+            history[head] = in[i];
+            head = (head + 1) % taps;
+            int64_t acc = 0;
+            for (size_t j = 0; j < taps; j++) {
+                acc += h[j] * (int64_t)history[(head + j) % taps];
+            }
+            if (i % FACTOR == FACTOR - 1) {
+                out[directCount++] = (uint32_t)((acc + (1 << 14)) >> 15);
+            }
+        }
+    });
+    host_test_sink = (float)out[directCount - 1];
+
+    printf("Decimator<%zu, %zu>::Process %6.2f ns/input sample (%zu MAC), direct FIR %7.2f ns/input sample (%zu MAC)\n",
+           FACTOR, TAPS, polyphaseNs / samples, TAPS, directNs / samples, taps);
+    CHECK(count == samples / FACTOR - (TAPS - 1));
+    CHECK(polyphaseNs < directNs);
+}
+
+int main() {
+    // Heart rate band: flat up to 8 Hz (480 bpm, well past the second harmonic of MAX_HR)
+    const double passband[] = {0.5, 1, 2, 3, 5, 8};
+    for (double hz : passband) {
+        double db = GainDb(hz);
+        printf("%6.1f Hz: %7.2f dB\n", hz, db);
+        CHECK_NEAR(db, 0.0, 0.2);
+    }
+
+    // Everything that would alias into the 0 - 12.5 Hz output band
+    const double stopband[] = {20, 23, 30, 37, 45, 60, 90, 120, 170, 199};
+    for (double hz : stopband) {
+        double db = GainDb(hz);
+        printf("%6.1f Hz: %7.2f dB\n", hz, db);
+        CHECK(db <= -55.0);
+    }
+
+    // DC passes unchanged once the start-up outputs are swallowed
+    uint32_t in[FACTOR * TAPS * 2], out[TAPS * 2 + 1];
+    for (uint32_t& x : in) {
+        x = 123456;
+    }
+    Decimator<uint32_t, FACTOR, TAPS> decimator;
+    size_t count = decimator.Process(in, FACTOR * TAPS * 2, out);
+    CHECK(count == TAPS + 1);
+    for (size_t m = 0; m < count; m++) {
+        CHECK(out[m] == 123456);
+    }
+
+    Benchmark();
+
+    return HostTestResult("test_decimator");
+}
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "host_test.h"
+#include "fake_max3010x.h"
+#include "MAX3010X.h"
+#include "task.h"
+
+// Byte-exact checks of the MAX3010X FIFO path: unpackFIFO() on hand-written words and
+// readFIFOBurst() against the FakeMAX3010X register file, for 1/2/3 LEDs, a wrapped
+// read pointer and a full 32-sample (288-byte) burst
+
+static uint32_t busyWaits;
+
+BaseType_t xTaskGetSchedulerState(void) {
+    return taskSCHEDULER_NOT_STARTED;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    (void)ticks;
+}
+
+void busy_wait_ms(uint32_t ms) {
+    (void)ms;
+    busyWaits++;
+}
+
+absolute_time_t get_absolute_time(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+// Distinct 18-bit values that exercise the top two bits and both byte edges
+static uint32_t Value(uint32_t sample, uint32_t led) {
+    static const uint32_t patterns[] = {0x00000, 0x3FFFF, 0x2A5A5, 0x15A5A, 0x10000, 0x0FFFF, 0x30001, 0x000FF};
+    return (patterns[(sample + led) % count_of(patterns)] + sample * 0x111 + led * 0x1001) & 0x3FFFF;
+}
+
+// Hand-packed words, MSB first. The unused top 6 bits are set and must be masked off.
+static void TestUnpack() {
+    const uint8_t words[] = {
+        0xFF, 0xFF, 0xFF,  // 0x3FFFF
+        0xFC, 0x00, 0x00,  // 0x00000
+        0x02, 0xA5, 0xA5,  // 0x2A5A5
+        0xA1, 0x23, 0x45,  // 0x12345
+        0x00, 0xFF, 0x00,  // 0x0FF00
+        0x7E, 0x00, 0x01,  // 0x20001
+    };
+    uint32_t red[6], ir[3], green[2];
+
+    MAX3010XBase::unpackFIFO(words, 6, 1, red, nullptr, nullptr);
+    const uint32_t red1[] = {0x3FFFF, 0x00000, 0x2A5A5, 0x12345, 0x0FF00, 0x20001};
+    CHECK(memcmp(red, red1, sizeof(red1)) == 0);
+
+    MAX3010XBase::unpackFIFO(words, 3, 2, red, ir, nullptr);
+    const uint32_t red2[] = {0x3FFFF, 0x2A5A5, 0x0FF00};
+    const uint32_t ir2[] = {0x00000, 0x12345, 0x20001};
+    CHECK(memcmp(red, red2, sizeof(red2)) == 0);
+    CHECK(memcmp(ir, ir2, sizeof(ir2)) == 0);
+
+    MAX3010XBase::unpackFIFO(words, 2, 3, red, ir, green);
+    const uint32_t red3[] = {0x3FFFF, 0x12345};
+    const uint32_t ir3[] = {0x00000, 0x0FF00};
+    const uint32_t green3[] = {0x2A5A5, 0x20001};
+    CHECK(memcmp(red, red3, sizeof(red3)) == 0);
+    CHECK(memcmp(ir, ir3, sizeof(ir3)) == 0);
+    CHECK(memcmp(green, green3, sizeof(green3)) == 0);
+
+    // A skipped channel still advances the source
+    uint32_t greenOnly[2] = {};
+    MAX3010XBase::unpackFIFO(words, 2, 3, nullptr, nullptr, greenOnly);
+    CHECK(memcmp(greenOnly, green3, sizeof(green3)) == 0);
+}
+
+// Configures the fake for leds LEDs, leaves the pointers at start and pushes count samples
+static void Prepare(MAX3010XBase& sensor, uint8_t leds, uint8_t start, uint32_t count) {
+    fakeMax3010x.Reset();
+    sensor.setup(0x1F, 4, leds, 400, 411, 4096);
+    fakeMax3010x.SetPointers(start, start);
+    for (uint32_t i = 0; i < count; i++) {
+        fakeMax3010x.Push(Value(i, 0), Value(i, 1), Value(i, 2));
+    }
+}
+
+// Reads one burst and checks the count, the single FIFO_DATA transfer and every byte.
+// first is the index of the oldest sample still in the FIFO.
+static void CheckBurst(MAX3010XBase& sensor, uint8_t leds, uint32_t first, uint16_t expected) {
+    uint8_t raw[MAX3010X_FIFO_BYTES];
+    memset(raw, 0xEE, sizeof(raw));
+    uint32_t reads = fakeMax3010x.reads;
+
+    uint16_t samples = sensor.readFIFOBurst(raw, sizeof(raw));
+    CHECK(samples == expected);
+    CHECK(fakeMax3010x.reads - reads == 2);  // pointers, then the data in one transfer
+    CHECK(fakeMax3010x.lastReadRegister == 0x07);
+    CHECK(fakeMax3010x.lastReadLength == (size_t)expected * leds * 3);
+
+    uint32_t red[MAX3010X_FIFO_DEPTH], ir[MAX3010X_FIFO_DEPTH], green[MAX3010X_FIFO_DEPTH];
+    MAX3010XBase::unpackFIFO(raw, samples, leds, red, ir, green);
+    bool match = true;
+    for (uint16_t i = 0; i < samples; i++) {
+        const uint8_t* word = &raw[i * leds * 3];
+        for (uint8_t led = 0; led < leds; led++, word += 3) {
+            uint32_t value = Value(first + i, led);
+            match = match && word[0] == (0xFC | value >> 16) && word[1] == (uint8_t)(value >> 8) && word[2] == (uint8_t)value;
+        }
+        match = match && red[i] == Value(first + i, 0);
+        if (leds > 1) match = match && ir[i] == Value(first + i, 1);
+        if (leds > 2) match = match && green[i] == Value(first + i, 2);
+    }
+    CHECK(match);
+    CHECK(raw[samples * leds * 3] == 0xEE || samples * leds * 3 == sizeof(raw));  // nothing past the burst
+}
+
+static void TestBurst(MAX3010XBase& sensor) {
+    for (uint8_t leds = 1; leds <= 3; leds++) {
+        Prepare(sensor, leds, 0, 17);
+        CheckBurst(sensor, leds, 0, 17);
+        CHECK(sensor.readFIFOBurst(nullptr, 0) == 0);  // drained
+
+        // Write pointer wrapped past the end: 28..31 then 0..5
+        Prepare(sensor, leds, 28, 10);
+        CheckBurst(sensor, leds, 0, 10);
+    }
+
+    // Empty FIFO: one pointer read, no data transfer
+    Prepare(sensor, 3, 12, 0);
+    uint32_t reads = fakeMax3010x.reads;
+    uint8_t raw[MAX3010X_FIFO_BYTES];
+    CHECK(sensor.readFIFOBurst(raw, sizeof(raw)) == 0);
+    CHECK(fakeMax3010x.reads - reads == 1);
+
+    // Full FIFO after a rollover: equal pointers, a non-zero overflow counter and the
+    // whole FIFO, 32 samples x 3 LEDs = 288 bytes, in one transfer. Sample 0 was lost.
+    Prepare(sensor, 3, 20, MAX3010X_FIFO_DEPTH + 1);
+    CheckBurst(sensor, 3, 1, MAX3010X_FIFO_DEPTH);
+    CHECK(fakeMax3010x.lastReadLength == MAX3010X_FIFO_BYTES);
+
+    // A short buffer takes whole samples only, the rest stays queued
+    Prepare(sensor, 3, 0, 10);
+    CHECK(sensor.readFIFOBurst(raw, 4 * 9 + 5) == 4);
+    CHECK(fakeMax3010x.lastReadLength == 4 * 9);
+    CheckBurst(sensor, 3, 4, 6);
+}
+
+// check() stores bursts in the per-LED storage across its wrap
+static void TestCheck() {
+    MAX3010X<32> sensor(i2c0, 4, 5, 400000);
+    Prepare(sensor, 2, 30, 20);
+    CHECK(sensor.check() == 20);
+    uint32_t red[32], ir[32];
+    CHECK(sensor.readSamples(red, ir, nullptr, 32) == 20);
+
+    fakeMax3010x.SetPointers(0, 0);
+    for (uint32_t i = 20; i < 45; i++) {
+        fakeMax3010x.Push(Value(i, 0), Value(i, 1), Value(i, 2));
+    }
+    CHECK(sensor.check() == 25);  // storage head runs from 20 to 45, wrapping at 32
+    CHECK(sensor.readSamples(red, ir, nullptr, 32) == 25);
+    bool match = true;
+    for (uint32_t i = 0; i < 25; i++) {
+        match = match && red[i] == Value(20 + i, 0) && ir[i] == Value(20 + i, 1);
+    }
+    CHECK(match);
+}
+
+int main() {
+    MAX3010X<32> sensor(i2c0, 4, 5, 400000);
+    TestUnpack();
+    TestBurst(sensor);
+    TestCheck();
+    CHECK(busyWaits == 0);  // the fake clears the reset bit at once, setup() never polls
+    return HostTestResult("test_max3010x_fifo");
+}
@@ -0,0 +1,189 @@
+#include <math.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "host_test.h"
+#include "freertos_host.h"
+#include "fake_max3010x.h"
+#include "oximeter.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+// The INT-driven oximeter acquisition on the host FreeRTOS port. The main thread stands for
+// the MAX3010X ADC: it fills the fake FIFO with a 75 bpm PPG at OXIMETER_FIFO_RATE and, when
+// A_FULL pulls the INT line low, raises the GPIO interrupt that runs Oximeter::IntHandler().
+// Checks that the I/O task wakes once per INT edge and never on its timeout, that no sample
+// is lost, that the DSP task turns the samples into heart rates, and that nothing on the way
+// busy-waits, sleeps or delays.
+
+typedef std::chrono::steady_clock Clock;
+
+static std::atomic<uint32_t> busyWaits(0), sleeps(0);
+
+absolute_time_t get_absolute_time(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+void sleep_ms(uint32_t ms) {
+    (void)ms;
+    sleeps++;
+}
+
+void busy_wait_ms(uint32_t ms) {
+    (void)ms;
+    busyWaits++;
+}
+
+// GPIO bank stand-in for PIN_INT_OXI: the registered raw handler, the enabled events and
+// the events latched for it
+static irq_handler_t intHandler;
+static uint32_t intEnabled;
+static std::atomic<uint32_t> intLatched(0);
+static bool bankEnabled;
+
+void gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    CHECK(gpio != PIN_INT_OXI || out == GPIO_IN);
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;  // INT is open drain
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler) {
+    if (gpio == PIN_INT_OXI) {
+        intHandler = handler;
+    }
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (gpio == PIN_INT_OXI) {
+        intEnabled = enabled ? intEnabled | event_mask : intEnabled & ~event_mask;
+    }
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio) {
+    return gpio == PIN_INT_OXI ? intLatched.load() & intEnabled : 0;
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask) {
+    if (gpio == PIN_INT_OXI) {
+        intLatched &= ~event_mask;
+    }
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (num == IO_IRQ_BANK0) {
+        bankEnabled = enabled;
+    }
+}
+
+// Latches an edge on the pin and runs the bank interrupt as the NVIC would
+static void RaiseIrq(uint32_t events) {
+    intLatched |= events;
+    if (bankEnabled && (intEnabled & events) && intHandler != nullptr) {
+        intHandler();
+    }
+}
+
+static const int SECONDS = 3;
+static const double HEART_RATE_BPM = 75.0;
+
+int main() {
+    Oximeter oximeter;
+
+    // The constructor may wait for the sensor to come up; from here on nothing waits
+    busyWaits = 0;
+    sleeps = 0;
+    uint32_t delays = HostTaskDelays();
+
+    // INT on A_FULL with OXIMETER_INT_SAMPLES waiting, rollover left on
+    CHECK(intHandler != nullptr && (intEnabled & GPIO_IRQ_EDGE_FALL) && bankEnabled);
+    CHECK(fakeMax3010x.regs[0x02] & 0x80);
+    CHECK(MAX3010X_FIFO_DEPTH - (fakeMax3010x.regs[0x08] & 0x0F) == OXIMETER_INT_SAMPLES);
+    CHECK(fakeMax3010x.regs[0x08] & 0x10);
+
+    // Other events on the bank are left alone, and an edge before the task exists is dropped
+    intLatched = GPIO_IRQ_EDGE_RISE;
+    intHandler();
+    CHECK(intLatched == GPIO_IRQ_EDGE_RISE);
+    intLatched = 0;
+    RaiseIrq(GPIO_IRQ_EDGE_FALL);
+    CHECK(intLatched == 0);
+
+    oximeter.StartTask();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // SECONDS of PPG in real time, one FIFO entry every 2.5 ms; the line falls when an
+    // enabled status bit sets and rises when the I/O task reads it back
+    const int samples = SECONDS * OXIMETER_FIFO_RATE;
+    uint32_t edges = 0;
+    Clock::time_point begin = Clock::now();
+    for (int i = 0; i < samples; i++) {
+        std::this_thread::sleep_until(begin + std::chrono::microseconds(i * 1000000LL / OXIMETER_FIFO_RATE));
+        double phase = 2 * M_PI * HEART_RATE_BPM / 60.0 * i / OXIMETER_FIFO_RATE;
+        uint32_t ir = (uint32_t)lround(100000 + 900 * sin(phase) + 250 * sin(2 * phase + 0.4));
+        uint32_t red = (uint32_t)lround(80000 + 500 * sin(phase) + 140 * sin(2 * phase + 0.4));
+        bool fell;
+        {
+            std::lock_guard<std::mutex> guard(fakeI2CLock);
+            bool asserted = fakeMax3010x.IntAsserted();
+            fakeMax3010x.Push(red, ir, 0);
+            fell = !asserted && fakeMax3010x.IntAsserted();
+        }
+        if (fell) {
+            edges++;
+            RaiseIrq(GPIO_IRQ_EDGE_FALL);
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    uint32_t wakeups = HostTaskWakeups("OximeterIO");
+    uint32_t timeouts = HostTaskTimeouts("OximeterIO");
+    uint32_t dspWakeups = HostTaskWakeups("OximeterDSP");
+    oximeter.StopTask();
+
+    uint32_t lost, left, reads;
+    {
+        std::lock_guard<std::mutex> guard(fakeI2CLock);
+        lost = fakeMax3010x.lost;
+        left = fakeMax3010x.stored;
+        reads = fakeMax3010x.reads;
+    }
+    printf("oximeter INT: %d samples in %.2f s, %u INT edges, I/O task %u wake-ups (%u timeouts), "
+           "DSP task %u wake-ups, %u reads, %u lost\n",
+           samples, seconds, (unsigned)edges, (unsigned)wakeups, (unsigned)timeouts, (unsigned)dspWakeups,
+           (unsigned)reads, (unsigned)lost);
+
+    // One wake-up per OXIMETER_INT_SAMPLES entries, each on an edge; a notification that
+    // lands while the task still drains lets its next take return without blocking
+    CHECK(edges >= (uint32_t)(samples / OXIMETER_INT_SAMPLES - 1) && edges <= (uint32_t)(samples / OXIMETER_INT_SAMPLES));
+    CHECK(wakeups <= edges && wakeups + 2 >= edges);
+    CHECK(timeouts == 0);
+    CHECK(dspWakeups <= wakeups);
+    CHECK(lost == 0 && left < OXIMETER_INT_SAMPLES);
+
+    // The samples made it through decimation into the HR/SpO2 window
+    Data_t data;
+    data.type = SAMPLE_TYPE_HEART_RATE;
+    CHECK(oximeter.getData(&data));
+    if (data.size > 0) {
+        printf("oximeter INT: %u heart rates, last %.0f bpm\n", (unsigned)data.size, data.data[data.size - 1]);
+        CHECK_NEAR(data.data[data.size - 1], HEART_RATE_BPM, 5.0);
+        oximeter.releaseData(&data);
+    }
+
+    // Paced by INT alone: the temperature poll found its result ready and nothing slept
+    CHECK(busyWaits == 0 && sleeps == 0);
+    CHECK(HostTaskDelays() == delays);
+    return HostTestResult("test_oximeter_int");
+}
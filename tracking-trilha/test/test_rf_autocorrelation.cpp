@@ -0,0 +1,159 @@
+#include <math.h>
+#include <stdlib.h>
+#include <complex>
+#include "host_test.h"
+#include "algorithm_by_RF.h"
+
+// The autocorrelation choices behind the RF pipelines, for ST = 1, 4 and 8 s windows at FS:
+// the blocked rf_fixed_autocorrelation_all() against one dot product per lag (what the
+// fixed-point pipeline did before), the float per-lag rf_autocorrelation() calls of the batch
+// function, and a radix-2 FFT, the path dropped because the lag range is too short for it.
+//
+// The Cortex-M0+ has no SIMD. test_rf_autocorrelation_scalar builds this file and the kernels
+// with auto-vectorization off (RF_BENCH_SCALAR), the closer model of the target: there the
+// blocked kernel must beat the per-lag dot products from ST=4 on. The default build lets the
+// compiler vectorize the per-lag loop and only reports.
+
+#ifndef RF_BENCH_SCALAR
+#define RF_BENCH_SCALAR 0
+#endif
+
+static const int REPEATS = 20000;
+
+// One dot product per lag, as rf_heart_rate_and_oxygen_saturation_fixed() filled its table before
+static void PerLagFixed(const int32_t* x, int32_t n, int32_t firstLag, int32_t lags, int32_t* aut) {
+    for (int32_t lag = firstLag; lag < lags; lag++) {
+        int32_t sum = 0;
+        for (int32_t i = 0; i < n - lag; i++) {
+            sum += x[i] * x[i + lag];
+        }
+        aut[lag] = lag < n ? sum / (n - lag) : 0;
+    }
+}
+
+// In-place iterative radix-2 FFT, inverse when sign is +1
+static void Fft(std::complex<float>* a, int size, const std::complex<float>* twiddles, int sign) {
+    for (int i = 1, j = 0; i < size; i++) {
+        int bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(a[i], a[j]);
+        }
+    }
+    for (int len = 2; len <= size; len <<= 1) {
+        int step = size / len;
+        for (int i = 0; i < size; i += len) {
+            for (int k = 0; k < len / 2; k++) {
+                std::complex<float> w = twiddles[k * step];
+                if (sign > 0) {
+                    w = std::conj(w);
+                }
+                std::complex<float> u = a[i + k], v = a[i + k + len / 2] * w;
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+            }
+        }
+    }
+}
+
+// Autocorrelation through |FFT|^2, zero-padded past the largest lag so nothing wraps
+static void FftAutocorrelation(const float* x, int32_t n, int32_t lags, int size, const std::complex<float>* twiddles,
+                               std::complex<float>* work, float* aut) {
+    for (int i = 0; i < size; i++) {
+        work[i] = i < n ? x[i] : 0.0f;
+    }
+    Fft(work, size, twiddles, -1);
+    for (int i = 0; i < size; i++) {
+        work[i] = std::norm(work[i]);
+    }
+    Fft(work, size, twiddles, +1);
+    for (int32_t lag = 0; lag < lags; lag++) {
+        aut[lag] = lag < n ? work[lag].real() / size / (n - lag) : 0.0f;
+    }
+}
+
+template <typename CFG>
+static void Benchmark() {
+    const rf_params_t& pp = CFG::PARAMS;
+    const int32_t n = pp.n_buffer_size;
+    const int32_t first = pp.n_aut_first_lag;
+    const int32_t lags = pp.n_aut_table_size;
+
+    // Detrended PPG-like residuals at 75 bpm, scaled as the fixed pipeline scales them
+    static int32_t x[CFG::BUFFER_SIZE];
+    static float xf[CFG::BUFFER_SIZE];
+    srand(2);
+    for (int32_t i = 0; i < n; i++) {
+        double phase = 2 * M_PI * 1.25 * i / CFG::FS;
+        x[i] = (int32_t)lround(1500 * sin(phase) + 400 * sin(2 * phase + 0.4)) + rand() % 64 - 32;
+        xf[i] = (float)x[i];
+    }
+
+    int32_t blocked[CFG::AUT_TABLE_SIZE] = {}, perLag[CFG::AUT_TABLE_SIZE] = {};
+    double blockedNs = TimeNs([&] {
+        for (int r = 0; r < REPEATS; r++) {
+            rf_fixed_autocorrelation_all(x, n, first, lags, blocked);
+            host_test_sink = (float)blocked[first];
+        }
+    });
+    double perLagNs = TimeNs([&] {
+        for (int r = 0; r < REPEATS; r++) {
+            PerLagFixed(x, n, first, lags, perLag);
+            host_test_sink = (float)perLag[first];
+        }
+    });
+    bool same = true;
+    for (int32_t lag = first; lag < lags; lag++) {
+        same = same && blocked[lag] == perLag[lag];
+    }
+    CHECK(same);
+
+    float autf[CFG::AUT_TABLE_SIZE] = {};
+    double floatNs = TimeNs([&] {
+        for (int r = 0; r < REPEATS; r++) {
+            for (int32_t lag = first; lag < lags; lag++) {
+                autf[lag] = rf_autocorrelation(xf, n, lag);
+            }
+            host_test_sink = autf[first];
+        }
+    });
+
+    int size = 1;
+    while (size < n + lags) {
+        size <<= 1;
+    }
+    std::complex<float> twiddles[512], work[1024];
+    for (int k = 0; k < size / 2; k++) {
+        twiddles[k] = std::polar(1.0f, (float)(-2 * M_PI * k / size));
+    }
+    float autFft[CFG::AUT_TABLE_SIZE] = {};
+    double fftNs = TimeNs([&] {
+        for (int r = 0; r < REPEATS; r++) {
+            FftAutocorrelation(xf, n, lags, size, twiddles, work, autFft);
+            host_test_sink = autFft[first];
+        }
+    });
+    double worst = 0;
+    for (int32_t lag = first; lag < lags; lag++) {
+        worst = fmax(worst, fabs(autFft[lag] - autf[lag]) / fabs(rf_autocorrelation(xf, n, 0)));
+    }
+    CHECK(worst < 1e-4);
+
+    printf("%s ST=%d (n=%3d, lags %2d..%2d): blocked %7.1f ns, per-lag fixed %7.1f ns, per-lag float %7.1f ns, FFT(%4d) %8.1f ns\n",
+           RF_BENCH_SCALAR ? "scalar" : "vector", (int)CFG::ST, (int)n, (int)first, (int)lags - 1, blockedNs / REPEATS, perLagNs / REPEATS,
+           floatNs / REPEATS, size, fftNs / REPEATS);
+    if (RF_BENCH_SCALAR && CFG::ST >= 4) {
+        CHECK(blockedNs < perLagNs);  // at ST=1 most blocks are tail, where the kernel gains nothing
+    }
+    CHECK(perLagNs < fftNs && floatNs < fftNs);
+}
+
+int main() {
+    Benchmark<RFConfig<FS, 1>>();
+    Benchmark<RFConfig<FS, 4>>();
+    Benchmark<RFConfig<FS, 8>>();
+    return HostTestResult(RF_BENCH_SCALAR ? "test_rf_autocorrelation_scalar" : "test_rf_autocorrelation");
+}
@@ -0,0 +1,141 @@
+#include <math.h>
+#include <stdlib.h>
+#include "host_test.h"
+#include "algorithm_by_RF.h"
+#include "algorithm_by_RF_stream.h"
+
+// The streaming and fixed-point HR/SpO2 pipelines against the batch function, window by window
+
+static const int TRACE_SAMPLES = 6000;  // 4 minutes at FS
+static uint32_t ir[TRACE_SAMPLES];
+static uint32_t red[TRACE_SAMPLES];
+
+// PPG-like trace: heart rate drifting between 60 and 100 bpm, a harmonic, baseline drift,
+// sensor noise and a burst of motion artifacts
+static void GenerateTrace() {
+    srand(1);
+    double phase = 0;
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        double t = (double)i/FS;
+        double hz = (80 + 20*sin(t/25))/60;
+        phase += 2*M_PI*hz/FS;
+        ir[i] = (uint32_t)(100000 + 900*sin(phase) + 250*sin(2*phase + 0.4) + 3*i + rand()%60);
+        red[i] = (uint32_t)(80000 + 500*sin(phase + 0.1) + 140*sin(2*phase + 0.5) - 2*i + rand()%60);
+        if (i > 3000 && i < 3200) {
+            ir[i] += rand()%5000;
+        }
+    }
+}
+
+typedef struct {
+    float spo2;
+    int8_t spo2Valid;
+    int32_t heartRate;
+    int8_t hrValid;
+    float ratio;
+    float correl;
+} rfResult_t;
+
+// Window ends the comparison visited, replayed by Benchmark()
+static int windowEnds[TRACE_SAMPLES];
+
+// Time of the float and the fixed-point pipeline over the same windows. The host has an FPU,
+// so the ratio understates the gain on the RP2040, where every float operation is a soft-float call.
+static void Benchmark(int windows) {
+    rfResult_t result = {};
+    double floatNs = TimeNs([&] {
+        for (int w = 0; w < windows; w++) {
+            int start = windowEnds[w] - BUFFER_SIZE + 1;
+            rf_heart_rate_and_oxygen_saturation(ir + start, BUFFER_SIZE, red + start, &result.spo2, &result.spo2Valid,
+                                                &result.heartRate, &result.hrValid, &result.ratio, &result.correl);
+            host_test_sink = result.spo2;
+        }
+    });
+
+    int32_t scratch[RF_FIXED_SCRATCH(RFDefaultConfig)];
+    int32_t lastPeriod = RFDefaultConfig::LOWEST_PERIOD;
+    double fixedNs = TimeNs([&] {
+        for (int w = 0; w < windows; w++) {
+            int start = windowEnds[w] - BUFFER_SIZE + 1;
+            rf_heart_rate_and_oxygen_saturation_fixed(&RFDefaultConfig::PARAMS, ir + start, red + start, scratch, &lastPeriod,
+                                                      &result.spo2, &result.spo2Valid, &result.heartRate, &result.hrValid,
+                                                      &result.ratio, &result.correl);
+            host_test_sink = result.spo2;
+        }
+    });
+
+    printf("float %8.2f us/window, fixed %8.2f us/window, float/fixed %.2f\n",
+           floatNs / windows / 1000, fixedNs / windows / 1000, floatNs / fixedNs);
+}
+
+int main() {
+    GenerateTrace();
+
+    RFStream<RFDefaultConfig> stream;
+    int32_t scratch[RF_FIXED_SCRATCH(RFDefaultConfig)];
+    int32_t fixedLastPeriod = RFDefaultConfig::LOWEST_PERIOD;
+
+    int windows = 0, hrValid = 0;
+    int streamMismatches = 0, fixedHrMismatches = 0, fixedValidMismatches = 0;
+    double streamSpo2 = 0, streamCorrel = 0, fixedSpo2 = 0, fixedCorrel = 0;
+
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        stream.Push(ir[i], red[i]);
+        if (!stream.Ready()) {
+            continue;
+        }
+        uint32_t* irWindow = ir + i - BUFFER_SIZE + 1;
+        uint32_t* redWindow = red + i - BUFFER_SIZE + 1;
+        rfResult_t batch = {}, streamed = {}, fixed = {};
+
+        rf_heart_rate_and_oxygen_saturation(irWindow, BUFFER_SIZE, redWindow, &batch.spo2, &batch.spo2Valid,
+                                            &batch.heartRate, &batch.hrValid, &batch.ratio, &batch.correl);
+        stream.Compute(&streamed.spo2, &streamed.spo2Valid, &streamed.heartRate, &streamed.hrValid,
+                       &streamed.ratio, &streamed.correl);
+        rf_heart_rate_and_oxygen_saturation_fixed(&RFDefaultConfig::PARAMS, irWindow, redWindow, scratch, &fixedLastPeriod,
+                                                  &fixed.spo2, &fixed.spo2Valid, &fixed.heartRate, &fixed.hrValid,
+                                                  &fixed.ratio, &fixed.correl);
+        windowEnds[windows++] = i;
+        hrValid += batch.hrValid;
+
+        // Exact integer sums: same decisions, floating-point noise only
+        if (streamed.heartRate != batch.heartRate || streamed.hrValid != batch.hrValid ||
+            streamed.spo2Valid != batch.spo2Valid) {
+            streamMismatches++;
+        }
+        if (batch.spo2Valid && streamed.spo2Valid) {
+            streamSpo2 = fmax(streamSpo2, fabs(streamed.spo2 - batch.spo2));
+        }
+        streamCorrel = fmax(streamCorrel, fabs(streamed.correl - batch.correl));
+
+        // Integer rounding may flip near ties in the periodicity search
+        if (fixed.hrValid != batch.hrValid || fixed.spo2Valid != batch.spo2Valid) {
+            fixedValidMismatches++;
+        } else if (fixed.heartRate != batch.heartRate) {
+            fixedHrMismatches++;
+        }
+        if (batch.spo2Valid && fixed.spo2Valid) {
+            fixedSpo2 = fmax(fixedSpo2, fabs(fixed.spo2 - batch.spo2));
+        }
+        fixedCorrel = fmax(fixedCorrel, fabs(fixed.correl - batch.correl));
+    }
+
+    printf("%d windows, %d with a valid heart rate\n", windows, hrValid);
+    printf("stream: %d mismatches, max |dSpO2| %g, max |dcorrel| %g\n", streamMismatches, streamSpo2, streamCorrel);
+    printf("fixed:  %d validity and %d heart rate mismatches, max |dSpO2| %g, max |dcorrel| %g\n",
+           fixedValidMismatches, fixedHrMismatches, fixedSpo2, fixedCorrel);
+
+    CHECK(hrValid > windows/2);  // the trace exercises the valid paths, not just the rejections
+
+    CHECK(streamMismatches == 0);
+    CHECK(streamSpo2 <= 1e-3);
+    CHECK(streamCorrel <= 1e-5);
+
+    CHECK(fixedValidMismatches <= windows/100);
+    CHECK(fixedHrMismatches <= windows/100);
+    CHECK(fixedSpo2 <= 0.1);
+    CHECK(fixedCorrel <= 1e-3);
+
+    Benchmark(windows);
+    return HostTestResult("test_rf_stream_fixed");
+}
@@ -0,0 +1,169 @@
+#include "host_test.h"
+#include "ring_buffer.h"
+#include "frame_buffer.h"
+#include "utils.h"
+
+// RingBuffer behaviour, then the per-sample cost against the shift_buffer() arrays it replaced
+
+static void TestOverwriteOldest() {
+    RingBuffer<float, 8> ring;
+    for (int i = 0; i < 20; i++) {
+        CHECK(ring.Push((float)i));
+    }
+    CHECK(ring.Size() == 8);
+
+    float out[8];
+    size_t count = ring.ReadAll(out, 8);
+    CHECK(count == 8);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(out[i] == (float)(12 + i));  // the newest 8 survive, oldest first
+    }
+    CHECK(ring.Dropped() == 12);
+    CHECK(ring.ReadAll(out, 8) == 0);  // nothing new since the last read
+}
+
+static void TestDropNewest() {
+    RingBuffer<int, 4, RING_POLICY_DROP_NEWEST> ring;
+    for (int i = 0; i < 6; i++) {
+        CHECK(ring.Push(i) == (i < 4));
+    }
+    int value;
+    CHECK(ring.Pop(&value) && value == 0);
+    CHECK(ring.Push(6));
+    int out[4];
+    CHECK(ring.ReadAll(out, 4) == 4);
+    CHECK(out[0] == 1 && out[3] == 6);
+    CHECK(ring.Dropped() == 2);
+}
+
+static void TestAcquireRelease() {
+    RingBuffer<float, 8> ring;
+    for (int i = 0; i < 5; i++) {
+        ring.Push((float)i);
+    }
+
+    // A view is contiguous even when it wraps
+    const float* view;
+    CHECK(ring.Acquire(&view) == 5);
+    CHECK(ring.Release(5));
+    for (int i = 5; i < 12; i++) {
+        ring.Push((float)i);
+    }
+    size_t count = ring.Acquire(&view);
+    CHECK(count == 7);
+    for (size_t i = 0; i < count; i++) {
+        CHECK(view[i] == (float)(5 + i));
+    }
+    CHECK(ring.Intact());
+
+    // The producer laps the held view: Release() reports it
+    for (int i = 12; i < 14; i++) {
+        ring.Push((float)i);
+    }
+    CHECK(!ring.Intact());
+    CHECK(!ring.Release(count));
+}
+
+// Stored once: half the storage, and a wrapped view comes out as two spans
+static void TestSplitLayout() {
+    typedef RingBuffer<float, 8, RING_POLICY_OVERWRITE_OLDEST, RING_LAYOUT_SPLIT> SplitRing;
+    static_assert(sizeof(SplitRing) + 8 * sizeof(float) == sizeof(RingBuffer<float, 8>), "split layout stores N elements");
+    SplitRing ring;
+    for (int i = 0; i < 5; i++) {
+        ring.Push((float)i);
+    }
+
+    RingSpans<float> view;
+    CHECK(ring.Acquire(&view) == 5);
+    CHECK(view.firstSize == 5 && view.secondSize == 0);
+    CHECK(ring.Release(5));
+    for (int i = 5; i < 12; i++) {
+        ring.Push((float)i);
+    }
+    size_t count = ring.Acquire(&view);
+    CHECK(count == 7 && view.Size() == 7);
+    CHECK(view.firstSize == 3 && view.secondSize == 4);  // slots 5..7, then 0..3
+    for (size_t i = 0; i < count; i++) {
+        CHECK(view[i] == (float)(5 + i));
+    }
+    CHECK(ring.Intact());
+    for (int i = 12; i < 14; i++) {
+        ring.Push((float)i);
+    }
+    CHECK(!ring.Intact());
+    CHECK(!ring.Release(count));
+
+    // ReadAll() joins the two spans, and still drops what was lapped
+    for (int i = 14; i < 30; i++) {
+        ring.Push((float)i);
+    }
+    float out[8];
+    CHECK(ring.ReadAll(out, 8) == 8);
+    for (size_t i = 0; i < 8; i++) {
+        CHECK(out[i] == (float)(22 + i));
+    }
+
+    // Frames are stored once as well; CopyChannel() walks both spans
+    FrameBuffer<2, 4> frames;
+    frames.SetScale(1, 0.5f, 1.0f);
+    for (int i = 0; i < 6; i++) {
+        const int16_t raw[2] = {(int16_t)i, (int16_t)(20 * i)};
+        frames.Push(100 + i, raw);
+    }
+    FrameBuffer<2, 4>::view_t frameView;
+    CHECK(frames.Acquire(&frameView) == 4);
+    CHECK(frameView.secondSize == 2);
+    float channel[4];
+    CHECK(frames.CopyChannel(frameView, 1, channel) == 4);
+    for (int i = 0; i < 4; i++) {
+        CHECK(frameView[i].timestamp == 102 + i);
+        CHECK(channel[i] == 10.0f * (2 + i) + 1.0f);
+    }
+    CHECK(frames.Release(4));
+}
+
+// Producer stream into a full buffer, as the sensors do once warmed up
+template <size_t N>
+static void BenchmarkAgainstShift() {
+    const int samples = 200000;
+
+    static float shiftData[N];
+    size_t shiftSize = 0;
+    double shiftNs = TimeNs([&] {
+        for (int i = 0; i < samples; i++) {
+            if (shiftSize == N) {
+                shift_buffer(shiftData, &shiftSize);
+            }
+            shiftData[shiftSize++] = (float)i;
+        }
+    });
+    host_test_sink = shiftData[N - 1];
+
+    static RingBuffer<float, N> ring;
+    double ringNs = TimeNs([&] {
+        for (int i = 0; i < samples; i++) {
+            ring.Push((float)i);
+        }
+    });
+    float out[N];
+    size_t count = ring.ReadAll(out, N);
+    host_test_sink = out[count - 1];
+    CHECK(count == N && out[N - 1] == shiftData[N - 1]);  // both hold the same newest samples
+
+    printf("N = %5zu: shift_buffer %8.2f ns/sample, RingBuffer %6.2f ns/sample\n",
+           N, shiftNs / samples, ringNs / samples);
+    CHECK(ringNs < shiftNs);
+}
+
+int main() {
+    TestOverwriteOldest();
+    TestDropNewest();
+    TestAcquireRelease();
+    TestSplitLayout();
+
+    BenchmarkAgainstShift<128>();  // MAX_BUFFER_SIZE
+    BenchmarkAgainstShift<512>();
+    BenchmarkAgainstShift<2048>();
+
+    return HostTestResult("test_ring_buffer");
+}
@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "host_test.h"
+#include "state_collect.h"
+#include "oximeter.h"
+
+// The cross-core rings under real concurrency: one producer thread and one consumer thread
+// per ring, each using the ring the way its firmware task does.
+//   StateReportBuffer  AnalysisTask Push()  -> StateTask Pop() one report at a time
+//   OximeterRawBuffer  OximeterIO Push()    -> OximeterDSP ReadAll() in FIFO-sized batches
+//   SampleBuffer       OximeterDSP Push()   -> AnalysisTask Acquire()/Release() views
+// Every item carries its sequence number in each field, so a reordered, repeated, lost or
+// torn item shows up. Reports the items per second each handoff sustains; on a single host
+// core the threads interleave by preemption instead of running side by side.
+
+typedef std::chrono::steady_clock Clock;
+
+static const uint32_t REPORTS = 1u << 20;
+static const uint32_t RAW_SAMPLES = 1u << 21;
+static const uint32_t VALUES = 1u << 22;  // exact in a float
+
+static stateReport_t MakeReport(uint32_t seq) {
+    stateReport_t report = {};
+    report.sensorType = (sensor_t)(seq % SENSOR_TYPE_QTT);
+    report.sampleIndex = seq;
+    report.first = (float)seq;
+    report.last = -(float)seq;
+    report.size = seq ^ 0x5A5A5A5Au;
+    report.analyzed = (seq & 1) != 0;
+    return report;
+}
+
+static bool ReportIs(const stateReport_t& report, uint32_t seq) {
+    stateReport_t expected = MakeReport(seq);
+    return report.sensorType == expected.sensorType && report.sampleIndex == expected.sampleIndex &&
+           report.first == expected.first && report.last == expected.last && report.size == expected.size &&
+           report.analyzed == expected.analyzed;
+}
+
+static void Print(const char* name, uint32_t items, double seconds) {
+    printf("%-18s %8u items in %6.1f ms: %6.1f M items/s, %5.1f ns per item\n", name, (unsigned)items, seconds * 1e3,
+           items / seconds / 1e6, seconds * 1e9 / items);
+}
+
+// Drop-newest: the producer retries what the ring refused, so every item must arrive once and in order
+static void TestReports() {
+    static StateReportBuffer ring;
+    uint32_t refused = 0;
+    std::atomic<uint32_t> bad(0);
+
+    Clock::time_point begin = Clock::now();
+    std::thread consumer([&] {
+        stateReport_t report;
+        for (uint32_t seq = 0; seq < REPORTS;) {
+            if (!ring.Pop(&report)) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (!ReportIs(report, seq++)) {
+                bad++;
+            }
+        }
+    });
+    for (uint32_t seq = 0; seq < REPORTS; seq++) {
+        while (!ring.Push(MakeReport(seq))) {
+            refused++;
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    Print("StateReportBuffer", REPORTS, seconds);
+    printf("%-18s producer retried %u pushes on a full ring\n", "", (unsigned)refused);
+    CHECK(bad == 0);
+    CHECK(ring.Empty());
+    CHECK(ring.Dropped() == refused);
+}
+
+static void TestRawSamples() {
+    static OximeterRawBuffer ring;
+    uint32_t refused = 0;
+    std::atomic<uint32_t> bad(0);
+
+    Clock::time_point begin = Clock::now();
+    std::thread consumer([&] {
+        oximeterSample_t raw[MAX3010X_STORAGE_SIZE];
+        for (uint32_t seq = 0; seq < RAW_SAMPLES;) {
+            size_t count = ring.ReadAll(raw, MAX3010X_STORAGE_SIZE);
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+            for (size_t i = 0; i < count; i++, seq++) {
+                if (raw[i].ir != seq || raw[i].red != ~seq) {
+                    bad++;
+                }
+            }
+        }
+    });
+    for (uint32_t seq = 0; seq < RAW_SAMPLES; seq++) {
+        while (!ring.Push({seq, ~seq})) {
+            refused++;
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    Print("OximeterRawBuffer", RAW_SAMPLES, seconds);
+    printf("%-18s producer retried %u pushes on a full ring\n", "", (unsigned)refused);
+    CHECK(bad == 0);
+    CHECK(ring.Empty());
+    CHECK(ring.Dropped() == refused);
+}
+
+// Overwrite-oldest: the producer never waits, so the consumer loses items, but a view
+// Release() calls intact must hold consecutive values past everything consumed before.
+// Bursts of up to twice the ring lap the consumer, and every fourth view is held across a
+// yield so the producer writes over it
+static void TestSampleViews() {
+    static SampleBuffer ring;
+    std::atomic<bool> done(false);
+    uint32_t views = 0, overwritten = 0, received = 0, bad = 0;
+
+    Clock::time_point begin = Clock::now();
+    std::thread producer([&] {
+        uint32_t burst = 0;
+        for (uint32_t seq = 0; seq < VALUES; seq++) {
+            ring.Push((float)seq);
+            if (--burst == 0 || burst > 2 * MAX_BUFFER_SIZE) {
+                burst = (seq * 37) % (2 * MAX_BUFFER_SIZE) + 1;
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+    float next = 0.0f;  // lowest value not consumed yet
+    for (;;) {
+        bool last = done;  // drain once more after the producer finished
+        const float* view;
+        size_t size = ring.Acquire(&view);
+        if (size == 0) {
+            if (last) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        if (++views % 4 == 0) {
+            std::this_thread::yield();
+        }
+        float first = view[0];
+        bool consecutive = true;
+        for (size_t i = 1; i < size; i++) {
+            consecutive = consecutive && view[i] == first + i;
+        }
+        if (!ring.Release(size)) {
+            overwritten++;
+            continue;
+        }
+        if (!consecutive || first < next) {
+            bad++;
+        }
+        next = first + size;
+        received += size;
+    }
+    producer.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    Print("SampleBuffer", VALUES, seconds);
+    printf("%-18s %u views, %u overwritten while held, %u values read intact, %u lost to the producer\n", "",
+           (unsigned)views, (unsigned)overwritten, (unsigned)received, (unsigned)ring.Dropped());
+    CHECK(bad == 0);
+    CHECK(views > 0 && received > 0);
+    CHECK(next == (float)VALUES);  // the last view held the newest value
+}
+
+int main() {
+    printf("%u host cores\n", std::thread::hardware_concurrency());
+    TestReports();
+    TestRawSamples();
+    TestSampleViews();
+    return HostTestResult("test_ring_spsc");
+}
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <string.h>
+#include "host_test.h"
+#include "display_oled.h"
+
+// Drives the OLED driver into an I2C stand-in that emulates the SSD1306 display RAM and
+// checks that what the display shows equals the framebuffer after every render
+
+struct i2c_inst {
+    int index;
+};
+static i2c_inst_t i2c0_inst = {0}, i2c1_inst = {1};
+i2c_inst_t* const i2c0 = &i2c0_inst;
+i2c_inst_t* const i2c1 = &i2c1_inst;
+
+// GDDRAM in horizontal addressing mode, the mode ssd1306_init() selects. Starts blank, as
+// the cleared framebuffer does.
+static uint8_t gddram[ssd1306_buffer_length];
+static int column, column_start, column_end = ssd1306_width - 1;
+static int page, page_start, page_end = ssd1306_n_pages - 1;
+static int argument;      // pending arguments of the last address command, 0 when none
+static uint8_t command;
+
+static long wire_bytes;   // address byte included
+static long transactions;
+
+// Number of argument bytes that follow a command
+static int ssd1306_arguments(uint8_t byte) {
+    switch (byte) {
+    case ssd1306_set_column_address:
+    case ssd1306_set_page_address:
+        return 2;
+    case ssd1306_set_horizontal_scroll:
+        return 6;
+    case ssd1306_set_memory_mode:
+    case ssd1306_set_contrast:
+    case ssd1306_set_charge_pump:
+    case ssd1306_set_mux_ratio:
+    case ssd1306_set_display_offset:
+    case ssd1306_set_display_clock_divide_ratio:
+    case ssd1306_set_precharge:
+    case ssd1306_set_common_pin_configuration:
+    case ssd1306_set_vcomh_deselect_level:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306_command(uint8_t byte) {
+    if (argument == 0) {
+        command = byte;
+        argument = ssd1306_arguments(byte);
+        return;
+    }
+    bool first = argument == 2;
+    argument--;
+    if (command == ssd1306_set_memory_mode) {
+        CHECK(byte == 0x00);  // horizontal addressing, the only mode emulated
+    } else if (command == ssd1306_set_column_address) {
+        if (first) {
+            column_start = column = byte;
+        } else {
+            column_end = byte;
+        }
+    } else if (command == ssd1306_set_page_address) {
+        if (first) {
+            page_start = page = byte;
+        } else {
+            page_end = byte;
+        }
+    }
+}
+
+int i2c_write_blocking(i2c_inst_t* i2c, uint8_t addr, const uint8_t* src, size_t len, bool nostop) {
+    (void)nostop;
+    CHECK(i2c == i2c1 && addr == ssd1306_i2c_address && len >= 2);
+    wire_bytes += len + 1;
+    transactions++;
+
+    if (src[0] == 0x40) {
+        for (size_t i = 1; i < len; i++) {
+            gddram[page * ssd1306_width + column] = src[i];
+            if (++column > column_end) {
+                column = column_start;
+                if (++page > page_end) {
+                    page = page_start;
+                }
+            }
+        }
+    } else if (src[0] == 0x80) {
+        CHECK(len == 2);  // one Co = 1 command byte per transaction
+        ssd1306_command(src[1]);
+    } else {
+        CHECK(src[0] == 0x00);  // a Co = 0 command stream
+        for (size_t i = 1; i < len; i++) {
+            ssd1306_command(src[i]);
+        }
+    }
+    return (int)len;
+}
+
+uint i2c_init(i2c_inst_t* i2c, uint baudrate) {
+    (void)i2c;
+    return baudrate;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_pull_up(uint gpio) {
+    (void)gpio;
+}
+
+static bool DisplayShows(const uint8_t* frame) {
+    return memcmp(gddram, frame, ssd1306_buffer_length) == 0;
+}
+
+// StateCollect-like reports: a status line, six sample lines with slowly changing values and
+// the health line, written over the previous frame and rendered once per frame
+static void TestReports() {
+    const int frames = 100;
+    long first_frame = 0, max_frame = 0, steady_bytes = 0;
+    float heart_rate = 72.0f, spo2 = 97.0f;
+
+    for (int frame = 0; frame < frames; frame++) {
+        char lines[MAX_LINES][MAX_CHAR + 1];
+        char *text[MAX_LINES];
+        float values[6] = {spo2, heart_rate, 36.5f, 0.01f * (frame % 3), 0.02f, 0.98f};
+        snprintf(lines[0], sizeof(lines[0]), "%-16s", "Coletando...");
+        for (int line = 0; line < 6; line++) {
+            snprintf(lines[line + 1], sizeof(lines[0]), "S%2d T%2d V%-6.1f", line < 3 ? 0 : 1, line, values[line]);
+        }
+        snprintf(lines[7], sizeof(lines[0]), "%-16s", "H 2");
+        for (int line = 0; line < MAX_LINES; line++) {
+            text[line] = lines[line];
+        }
+
+        print_lines_OLed(text, MAX_LINES, 0, 0);
+        long before = wire_bytes;
+        render_OLed();
+        long sent = wire_bytes - before;
+
+        CHECK(DisplayShows(ssd));
+        if (frame == 0) {
+            first_frame = sent;
+        } else {
+            steady_bytes += sent;
+            if (sent > max_frame) {
+                max_frame = sent;
+            }
+        }
+
+        if (frame % 4 == 0) {
+            heart_rate += 1.0f;
+        }
+        if (frame % 10 == 0) {
+            spo2 = spo2 == 97.0f ? 98.0f : 97.0f;
+        }
+    }
+
+    printf("first frame %ld bytes, then %.1f bytes per frame on average and %ld at most (full frame %d)\n",
+           first_frame, (double)steady_bytes / (frames - 1), max_frame, ssd1306_frame_length + 1);
+    CHECK(first_frame <= ssd1306_frame_length + 1 + 16);  // never more than a full frame and its window
+    CHECK(steady_bytes / (frames - 1) < (ssd1306_frame_length + 1) / 8);
+
+    // Clearing sends only what was lit, and the display ends blank
+    clear_OLed();
+    render_OLed();
+    CHECK(DisplayShows(ssd));
+
+    // Nothing changed: nothing sent
+    long before = wire_bytes;
+    render_OLed();
+    CHECK(wire_bytes == before);
+}
+
+// The display task may flush less often than frames are presented, and drawing goes on in
+// the back buffer between a present and its flush
+static void TestPresentFlush() {
+    for (int frame = 0; frame < 200; frame++) {
+        char value[MAX_CHAR + 1];
+        snprintf(value, sizeof(value), "V%5d", frame * 37);
+        char *text[] = {value};
+        print_lines_OLed(text, 1, (frame % 5) * 8, (frame % 8) * 8);
+        draw_line_OLed(frame % ssd1306_width, 0, ssd1306_width - 1 - frame % ssd1306_width, ssd1306_height - 1, frame & 1);
+        present_OLed();
+
+        // Only every third present is flushed
+        if (frame % 3 == 2) {
+            flush_OLed();
+            CHECK(DisplayShows(ssd_front));
+            CHECK(memcmp(ssd_front, ssd, ssd1306_buffer_length) == 0);
+        }
+
+        // The front buffer does not follow the back one until the next present
+        uint8_t front[ssd1306_buffer_length];
+        memcpy(front, ssd_front, ssd1306_buffer_length);
+        char marker[] = "XXXX";
+        char *marker_text[] = {marker};
+        print_lines_OLed(marker_text, 1, 0, ssd1306_height - CHAR_HEIGHT);
+        CHECK(memcmp(front, ssd_front, ssd1306_buffer_length) == 0);
+        present_OLed();
+    }
+    flush_OLed();
+    CHECK(DisplayShows(ssd));
+}
+
+int main() {
+    init_OLed();
+    render_OLed();
+    CHECK(DisplayShows(ssd));
+
+    long init_transactions = transactions;
+    TestReports();
+    TestPresentFlush();
+    printf("%ld bytes in %ld transactions after init\n", wire_bytes, transactions - init_transactions);
+
+    return HostTestResult("test_ssd1306_dirty");
+}
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "host_test.h"
+#include "freertos_host.h"
+#include "fake_imu6050.h"
+#include "state_collect.h"
+#include "accelerometer.h"
+
+// Replays sensor publishes through the StateCollect event path on the host FreeRTOS port:
+// Publish() -> sensor semaphore -> queue set -> AnalysisTask -> reports ring -> reportsReady
+// -> StateTask -> OLED frame. Reports the publish-to-frame latency and how often both tasks
+// wake, idle and under load. Then the exception: the accelerometer is still polled, so its
+// samples first wait in the IMU FIFO for the next StateTask poll, 100 to 500 ms by profile.
+
+typedef std::chrono::steady_clock Clock;
+
+static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+absolute_time_t get_absolute_time(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t) {
+    return (uint32_t)(t / 1000);
+}
+
+// The fake devices are ready at once
+void sleep_ms(uint32_t ms) {
+    (void)ms;
+}
+
+void busy_wait_ms(uint32_t ms) {
+    (void)ms;
+}
+
+// OLED stand-in: StateTask presents one frame per batch of reports it showed
+static std::atomic<uint32_t> oledFrames(0);
+static std::atomic<int64_t> oledFrameNs(0);
+
+Oled::Oled() {}
+Oled::~Oled() {}
+
+void Oled::PrintText(int line_index, const char* text) {
+    (void)line_index;
+    (void)text;
+}
+
+void Oled::Render() {
+    oledFrameNs = NowNs();
+    oledFrames++;
+}
+
+// Never reached: the replays register no Oximeter for the governor to configure
+void Oximeter::SetProfile(const oximeterProfile_t* profile) {
+    (void)profile;
+}
+
+// Publishes one heart rate per Emit(), as the oximeter DSP task does after a result
+class EventSensor : public Sensor {
+  public:
+    EventSensor() { sensorType = SENSOR_TYPE_OXIMETER; }
+
+    void Update() {}
+
+    bool getData(Data_t* data) {
+        if (data->type != SAMPLE_TYPE_HEART_RATE) {
+            return false;
+        }
+        data->size = values.Acquire(&data->data);
+        return data->size > 0;
+    }
+
+    bool releaseData(Data_t* data) { return values.Release(data->size); }
+
+    size_t GetSampleTypes(const sample_t** types) {
+        static const sample_t samples[] = {SAMPLE_TYPE_HEART_RATE};
+        *types = samples;
+        return 1;
+    }
+
+    void Emit(float value) {
+        values.Push(value);
+        Publish();
+    }
+
+  private:
+    SampleBuffer values;
+};
+
+static const int PUBLISHES = 200;
+static const uint32_t PUBLISH_PERIOD_MS = 10;  // 100 results per second, above any oximeter profile
+
+static double eventMedianUs;
+
+static void ReplayEvents() {
+    EventSensor sensor;
+    Oled oled;
+    StateCollect state;
+    CHECK(state.AddSensor(&sensor));
+    state.setOled(&oled);
+    state.StartTask();
+
+    // Idle: nothing published, neither task wakes
+    uint32_t analysisWakeups = HostTaskWakeups("AnalysisTask");
+    uint32_t stateWakeups = HostTaskWakeups("StateTask");
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    uint32_t idleWakeups = HostTaskWakeups("AnalysisTask") - analysisWakeups + HostTaskWakeups("StateTask") - stateWakeups;
+    CHECK(idleWakeups == 0);
+
+    // One publish every PUBLISH_PERIOD_MS, each followed to its OLED frame
+    std::vector<double> latencyUs;
+    analysisWakeups = HostTaskWakeups("AnalysisTask");
+    stateWakeups = HostTaskWakeups("StateTask");
+    Clock::time_point begin = Clock::now();
+    for (int i = 0; i < PUBLISHES; i++) {
+        std::this_thread::sleep_until(begin + std::chrono::milliseconds(i * PUBLISH_PERIOD_MS));
+        uint32_t shown = oledFrames;
+        int64_t published = NowNs();
+        sensor.Emit((float)i);
+        while (oledFrames == shown && NowNs() - published < 1000000000) {
+            std::this_thread::yield();
+        }
+        if (oledFrames != shown) {
+            latencyUs.push_back((oledFrameNs - published) / 1000.0);
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    analysisWakeups = HostTaskWakeups("AnalysisTask") - analysisWakeups;
+    stateWakeups = HostTaskWakeups("StateTask") - stateWakeups;
+    state.StopTask();
+
+    // One wake-up per task per publish, none spent polling
+    CHECK(latencyUs.size() == (size_t)PUBLISHES);
+    CHECK(analysisWakeups == (uint32_t)PUBLISHES);
+    CHECK(stateWakeups == (uint32_t)PUBLISHES);
+    CHECK(HostTaskTimeouts("StateTask") == 0 && HostTaskTimeouts("AnalysisTask") == 0);
+    if (latencyUs.empty()) {
+        return;
+    }
+
+    std::sort(latencyUs.begin(), latencyUs.end());
+    eventMedianUs = latencyUs[latencyUs.size() / 2];
+    double p99Us = latencyUs[latencyUs.size() * 99 / 100];
+    printf("event path: %d publishes at %.0f/s, publish -> OLED frame median %.0f us, p99 %.0f us, max %.0f us\n",
+           PUBLISHES, PUBLISHES / seconds, eventMedianUs, p99Us, latencyUs.back());
+    printf("event path: wake-ups/s AnalysisTask %.1f, StateTask %.1f (%.2f per publish); idle 0/s\n",
+           analysisWakeups / seconds, stateWakeups / seconds, (double)(analysisWakeups + stateWakeups) / PUBLISHES);
+    CHECK(p99Us < 20000.0);  // a handoff between threads, far below any poll period
+}
+
+// One governor profile of the polled replay, measured over seconds
+static void MeasurePolled(const char* profile, uint32_t periodMs, double seconds) {
+    {
+        std::lock_guard<std::mutex> guard(fakeI2CLock);
+        fakeImu6050.ResetStats();
+    }
+    uint32_t polls = HostTaskTimeouts("StateTask");
+    uint32_t stateWakeups = HostTaskWakeups("StateTask");
+    uint32_t analysisWakeups = HostTaskWakeups("AnalysisTask");
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    polls = HostTaskTimeouts("StateTask") - polls;
+    stateWakeups = HostTaskWakeups("StateTask") - stateWakeups;
+    analysisWakeups = HostTaskWakeups("AnalysisTask") - analysisWakeups;
+
+    uint32_t drained;
+    double meanWaitMs, maxWaitMs;
+    {
+        std::lock_guard<std::mutex> guard(fakeI2CLock);
+        drained = fakeImu6050.drained;
+        meanWaitMs = drained > 0 ? fakeImu6050.waitSumUs / 1000.0 / drained : 0.0;
+        maxWaitMs = fakeImu6050.waitMaxUs / 1000.0;
+    }
+
+    printf("polled %-7s (%3u ms): %4.1f polls/s, %3u frames, FIFO wait mean %5.1f ms, max %5.1f ms "
+           "(event path %.0f us); wake-ups/s StateTask %4.1f, AnalysisTask %4.1f\n",
+           profile, (unsigned)periodMs, polls / seconds, (unsigned)drained, meanWaitMs, maxWaitMs, eventMedianUs,
+           stateWakeups / seconds, analysisWakeups / seconds);
+
+    // A frame waits half a period on average and up to a whole one. Every poll wakes
+    // AnalysisTask once, and StateTask once more when the reports land after it went
+    // back to sleep rather than before
+    double rate = 1000.0 / periodMs;
+    CHECK(drained > 0);
+    CHECK_NEAR(polls / seconds, rate, 0.2 * rate);
+    CHECK_NEAR(meanWaitMs, periodMs / 2.0, 0.2 * periodMs);
+    CHECK(maxWaitMs > 0.8 * periodMs && maxWaitMs < periodMs + 25.0);
+    CHECK_NEAR(analysisWakeups / seconds, rate, 0.2 * rate);
+    CHECK(stateWakeups / seconds > 0.8 * rate && stateWakeups / seconds < 2.2 * rate);
+}
+
+static void ReplayPolled() {
+    Accelerometer accelerometer;  // an IMU6050 lying still on the fake bus
+    Oled oled;
+    StateCollect state;
+    CHECK(state.AddSensor(&accelerometer));
+    state.setOled(&oled);
+    Clock::time_point begin = Clock::now();
+    state.StartTask();
+
+    // The governor starts in RUNNING and moves to REST once the wearer stood still for
+    // GOVERNOR_HOLD_MS
+    const activityProfile_t& running = ActivityGovernor::profiles[ACTIVITY_PROFILE_RUNNING];
+    const activityProfile_t& rest = ActivityGovernor::profiles[ACTIVITY_PROFILE_REST];
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    MeasurePolled(running.name, running.statePeriodMs, 1.5);
+    std::this_thread::sleep_until(begin + std::chrono::milliseconds(GOVERNOR_HOLD_MS + 2 * rest.statePeriodMs));
+    MeasurePolled(rest.name, rest.statePeriodMs, 3.0);
+    state.StopTask();
+}
+
+int main() {
+    ReplayEvents();
+    ReplayPolled();
+    return HostTestResult("test_state_events");
+}
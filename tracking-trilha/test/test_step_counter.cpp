@@ -0,0 +1,68 @@
+#include <math.h>
+#include <random>
+#include <vector>
+#include "host_test.h"
+#include "step_counter.h"
+
+// Step and cadence accuracy on synthetic walking and running traces, then the per-sample cost
+
+static const float SAMPLE_RATE = 100.0f;  // ACCEL_ODR_HZ
+
+static std::mt19937 generator(1);
+static std::normal_distribution<float> noise(0.0f, 0.02f);
+
+// Vertical impacts at hz steps per second with a peak of about amplitude g over gravity, plus
+// sensor noise on every axis. hz = 0 stands still.
+static void Feed(StepCounter& counter, float hz, float amplitude, float seconds) {
+    static int t = 0;
+    for (int i = 0; i < (int)(seconds * SAMPLE_RATE); i++, t++) {
+        float cycle = 0.5f + 0.5f * cosf(2.0f * (float)M_PI * hz * t / SAMPLE_RATE);
+        float impact = 2.0f * amplitude * cycle * cycle - 0.5f * amplitude;
+        counter.Push(noise(generator), noise(generator), 1.0f + impact + noise(generator));
+    }
+}
+
+int main() {
+    StepCounter counter(SAMPLE_RATE);
+
+    // 30 s walking at 108 steps/min
+    Feed(counter, 1.8f, 0.3f, 30.0f);
+    uint32_t walked = counter.Steps();
+    printf("walk:  %u steps, %.1f steps/min\n", walked, counter.Cadence());
+    CHECK_NEAR(walked, 54, 2);
+    CHECK_NEAR(counter.Cadence(), 108.0, 3.0);
+
+    // Standing still: the crest the walk ended on may still be credited, nothing after it,
+    // and the cadence falls back to 0
+    Feed(counter, 0.0f, 0.001f, 1.0f);
+    walked = counter.Steps();
+    Feed(counter, 0.0f, 0.001f, 9.0f);
+    printf("still: %u steps, %.1f steps/min\n", counter.Steps(), counter.Cadence());
+    CHECK_NEAR(walked, 54, 2);
+    CHECK(counter.Steps() == walked);
+    CHECK(counter.Cadence() == 0.0f);
+
+    // 20 s running at 168 steps/min
+    Feed(counter, 2.8f, 0.8f, 20.0f);
+    uint32_t ran = counter.Steps() - walked;
+    printf("run:   %u steps, %.1f steps/min\n", ran, counter.Cadence());
+    CHECK_NEAR(ran, 56, 2);
+    CHECK_NEAR(counter.Cadence(), 168.0, 4.0);
+
+    // Throughput on noisy input
+    const int samples = 5000000;
+    std::vector<float> input(samples);
+    for (float& x : input) {
+        x = 1.0f + 5.0f * noise(generator);
+    }
+    StepCounter bench(SAMPLE_RATE);
+    double ns = TimeNs([&] {
+        for (int i = 0; i < samples; i++) {
+            bench.Push(0.1f * input[i], 0.1f * input[(i + 7) % samples], input[i]);
+        }
+    });
+    host_test_sink = (float)bench.Steps();
+    printf("%.1f Msamples/s, %.1f ns/sample\n", samples / ns * 1e3, ns / samples);
+
+    return HostTestResult("test_step_counter");
+}